@@ -5,8 +5,23 @@
 #include <signal.h>
 #include <time.h>
 #include <execinfo.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <math.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 
 #define NUM_PRIORITY_LEVELS 4
+#define MAX_DEFERRED 64     /* pending bottom halves in event-loop mode */
+#define WORK_STEPS 5        /* steps of deferred work per interrupt */
+#define TICK_MS 1000        /* main loop iteration / work step period */
+#define MAX_PENDING 1024    /* interrupt controller pending queue capacity */
+#define MAX_GENERATORS 16   /* signal generator threads in benchmark mode */
+#define LATENCY_BUCKETS 32  /* log2 histogram buckets, bucket b holds [2^b, 2^(b+1)) ns */
+#define BURST_NS 1000000L   /* generators send one burst per millisecond */
 
 /* signal handlers declarations */
 void proces_event(int sig);
@@ -18,9 +33,46 @@ int interrupt_occurred = 0; // Flag to track interrupt occurrence
 int control_flag = 0; // Control flag
 int current_priority = 0; // Current priority
 
+/* deferred work queued by the top half, processed one step per tick */
+struct deferred_work {
+    int sig;
+    int step;
+    long long raised_us; /* when the interrupt was raised */
+};
+
+struct deferred_work work_queue[MAX_DEFERRED];
+int work_head = 0, work_count = 0;
+
+/* timerfd-driven interrupt sources used by the event loop */
+struct timer_source {
+    const char *name;
+    long period_us;     /* 0 for a one-shot source */
+    long jitter_us;     /* each expiry lands up to +-jitter from the nominal time */
+    long first_us;      /* delay of the first expiry */
+    int queues_work;    /* expiry queues deferred work like SIGUSR1 does */
+    int fd;
+    long long base_us;  /* nominal time of the next expiry, without jitter */
+    long long armed_us; /* when the timer is actually due */
+    long fired, overruns;
+    long long total_drift_us, max_drift_us;
+};
+
+struct timer_source timer_sources[] = {
+    { "tick",      1000,       0,       1000, 0 },
+    { "sensor",    250000,     20000,   250000, 0 },
+    { "interrupt", 3000000,    2000000, 3000000, 1 }, /* replaces sleep(1..5s) + kill */
+    { "watchdog",  0,          0,       10000000, 0 },
+};
+#define NUM_TIMER_SOURCES (int)(sizeof(timer_sources) / sizeof(timer_sources[0]))
+
+long long now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 // Function to simulate hardware interrupt
 void simulate_interrupt() {
-    srand(time(NULL));
     int interval = rand() % 5 + 1; // Random interval between 1 and 5 seconds
     sleep(interval);
     kill(getpid(), SIGUSR1); // Raise SIGUSR1 to simulate interrupt
@@ -49,9 +101,553 @@ void print_stack() {
     free(strings);
 }
 
-int main()
+/* queue one bottom half; raised_us is when the interrupt was raised */
+void queue_work(int sig, long long raised_us) {
+    if (work_count == MAX_DEFERRED) {
+        printf("Deferred work queue full, dropping signal %d\n", sig);
+        return;
+    }
+    struct deferred_work *w = &work_queue[(work_head + work_count) % MAX_DEFERRED];
+    w->sig = sig;
+    w->step = 0;
+    w->raised_us = raised_us;
+    work_count++;
+    control_flag = 1;
+    printf("Event queued for signal %d (SIGUSR1), dispatch latency %lld us, %d pending\n",
+           sig, now_us() - raised_us, work_count);
+}
+
+/* top half: runs as soon as signalfd reports the signal, only queues work */
+void top_half(struct signalfd_siginfo *info) {
+    switch (info->ssi_signo) {
+    case SIGUSR1:
+        queue_work(info->ssi_signo, now_us());
+        break;
+    case SIGTERM:
+        printf("Received SIGTERM, saving data before exit\n");
+        run = 0;
+        break;
+    case SIGINT:
+        printf("Received SIGINT, canceling process\n");
+        exit(1);
+    }
+}
+
+/* arm a source for absolute time base_us plus a random jitter */
+void arm_timer_source(struct timer_source *src) {
+    long long due = src->base_us;
+    if (src->jitter_us > 0)
+        due += rand() % (2 * src->jitter_us + 1) - src->jitter_us;
+    src->armed_us = due;
+
+    struct itimerspec its = { { 0, 0 }, { due / 1000000, (due % 1000000) * 1000 } };
+    timerfd_settime(src->fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+/* a source's timerfd became readable */
+void timer_expired(struct timer_source *src) {
+    uint64_t expirations;
+    if (read(src->fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;
+
+    long long now = now_us();
+    long long drift = now - src->armed_us;
+    src->fired++;
+    src->total_drift_us += drift;
+    if (drift > src->max_drift_us)
+        src->max_drift_us = drift;
+
+    if (src->queues_work)
+        queue_work(SIGUSR1, src->armed_us);
+    if (src->period_us == 0) {
+        printf("Timer '%s' fired once, %lld us late\n", src->name, drift);
+        return;
+    }
+
+    /* next nominal expiry; periods we were too late for count as overruns */
+    src->base_us += src->period_us;
+    if (now >= src->base_us) {
+        long missed = (now - src->base_us) / src->period_us + 1;
+        src->overruns += missed;
+        src->base_us += missed * src->period_us;
+    }
+    arm_timer_source(src);
+}
+
+void print_timer_report() {
+    printf("%-10s %10s %8s %10s %14s %14s\n", "TIMER", "PERIOD_us", "FIRED", "OVERRUNS",
+           "AVG_DRIFT_us", "MAX_DRIFT_us");
+    for (int t = 0; t < NUM_TIMER_SOURCES; t++) {
+        struct timer_source *src = &timer_sources[t];
+        printf("%-10s %10ld %8ld %10ld %14.1f %14lld\n", src->name, src->period_us, src->fired,
+               src->overruns, src->fired ? (double)src->total_drift_us / src->fired : 0.0,
+               src->max_drift_us);
+    }
+}
+
+/* bottom half: one step of the oldest queued event per call */
+void bottom_half_step() {
+    struct deferred_work *w = &work_queue[work_head];
+
+    if (w->step == 0) {
+        printf("Event processing started for signal %d (SIGUSR1)\n", w->sig);
+        current_priority = NUM_PRIORITY_LEVELS - 1; // Set current priority to highest
+        print_system_state("Handling Interrupt");
+    }
+    w->step++;
+    printf("Processing signal %d: %d/%d\n", w->sig, w->step, WORK_STEPS);
+    if (w->step < WORK_STEPS)
+        return;
+
+    printf("Event processing completed for signal %d (SIGUSR1), %lld ms after it was raised\n",
+           w->sig, (now_us() - w->raised_us) / 1000);
+    work_head = (work_head + 1) % MAX_DEFERRED;
+    work_count--;
+    interrupt_occurred = 1; // Set interrupt flag
+    current_priority = 0; // Reset current priority
+    if (work_count == 0)
+        control_flag = 0; // Reset control flag
+}
+
+/*
+ * Event-loop mode: SIGUSR1, SIGTERM and SIGINT stay blocked and are read
+ * from a signalfd watched by epoll, so nothing runs in signal context.
+ * Interrupts come from timerfd sources on CLOCK_MONOTONIC in the same
+ * epoll set, so the main loop never blocks on them and keeps iterating
+ * while queued events are processed step by step.
+ */
+int run_event_loop()
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (sfd == -1 || epfd == -1) {
+        perror("signalfd/epoll_create1");
+        return 1;
+    }
+    /* data.ptr is NULL for the signalfd, the timer source otherwise */
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epfd, EPOLL_CTL_ADD, sfd, &ev);
+
+    printf("Process with PID=%ld started (event loop)\n", (long)getpid());
+
+    long long now = now_us();
+    for (int t = 0; t < NUM_TIMER_SOURCES; t++) {
+        struct timer_source *src = &timer_sources[t];
+        src->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (src->fd == -1) {
+            perror("timerfd_create");
+            return 1;
+        }
+        src->base_us = now + src->first_us;
+        arm_timer_source(src);
+        ev.data.ptr = src;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, src->fd, &ev);
+    }
+
+    long long next_iteration = now;
+    long long next_step = now;
+    int i = 1;
+
+    while (run) {
+        /* sleep until the next tick or work step, or until an fd is ready */
+        long long deadline = next_iteration;
+        if (work_count > 0 && next_step < deadline)
+            deadline = next_step;
+        long long wait_us = deadline - now_us();
+        int timeout = wait_us > 0 ? (int)((wait_us + 999) / 1000) : 0;
+
+        struct epoll_event events[NUM_TIMER_SOURCES + 1];
+        int n = epoll_wait(epfd, events, NUM_TIMER_SOURCES + 1, timeout);
+        for (int e = 0; e < n; e++) {
+            if (events[e].data.ptr != NULL) {
+                timer_expired(events[e].data.ptr);
+                continue;
+            }
+            struct signalfd_siginfo info;
+            while (read(sfd, &info, sizeof(info)) == sizeof(info))
+                top_half(&info);
+        }
+
+        now = now_us();
+        if (work_count > 0 && now >= next_step) {
+            bottom_half_step();
+            next_step = now + TICK_MS * 1000LL;
+        }
+        if (interrupt_occurred) {
+            print_system_state("Interrupt Handling");
+            interrupt_occurred = 0; // Reset interrupt flag
+        }
+        if (now >= next_iteration) {
+            printf("Process: iteration %d\n", i++);
+            next_iteration += TICK_MS * 1000LL;
+        }
+        fflush(stdout);
+    }
+
+    print_timer_report();
+    for (int t = 0; t < NUM_TIMER_SOURCES; t++)
+        close(timer_sources[t].fd);
+    close(epfd);
+    close(sfd);
+    printf("Process with PID=%ld finished\n", (long)getpid());
+    return 0;
+}
+
+/*
+ * Nested priority interrupt controller simulation (-p).
+ * Level 0 is the interrupted program; sources raise levels 1..NUM_PRIORITY_LEVELS-1.
+ * While a level is in service, level_mask[level] blocks it and everything
+ * below, so only a strictly higher level can preempt the running handler.
+ * Requests that cannot be delivered wait in a priority queue (highest level
+ * first, then oldest). Runs in simulated time, so storms are reproducible.
+ */
+struct irq_source {
+    const char *name;
+    int priority;
+    double mean_interarrival_us;
+    double service_us;
+};
+
+struct irq_source irq_sources[] = {
+    { "timer",    3,  1000.0,  20.0 },
+    { "disk",     2,  4000.0, 300.0 },
+    { "network",  2,  1500.0, 150.0 },
+    { "keyboard", 1, 20000.0,  50.0 },
+    { "serial",   1,  5000.0, 400.0 },
+};
+#define NUM_IRQ_SOURCES (int)(sizeof(irq_sources) / sizeof(irq_sources[0]))
+
+struct irq_request {
+    int source;
+    double arrival;
+    double start;     /* first dispatch, -1 while pending */
+    double remaining; /* service time still owed */
+};
+
+struct level_stats {
+    long raised, dispatched, serviced, preempted, dropped;
+    double total_queueing, max_queueing;
+    double total_latency, max_latency;
+};
+
+unsigned level_mask[NUM_PRIORITY_LEVELS];
+struct irq_request pending[MAX_PENDING];
+int num_pending = 0;
+struct irq_request in_service[NUM_PRIORITY_LEVELS]; /* nesting stack */
+int nesting = 0;
+struct level_stats level_stats[NUM_PRIORITY_LEVELS];
+
+/* a outranks b: higher level first, then earlier arrival */
+int irq_before(struct irq_request *a, struct irq_request *b) {
+    int pa = irq_sources[a->source].priority, pb = irq_sources[b->source].priority;
+    return pa != pb ? pa > pb : a->arrival < b->arrival;
+}
+
+void pending_push(struct irq_request req) {
+    int i = num_pending++;
+    pending[i] = req;
+    while (i > 0 && irq_before(&pending[i], &pending[(i - 1) / 2])) {
+        struct irq_request tmp = pending[i];
+        pending[i] = pending[(i - 1) / 2];
+        pending[(i - 1) / 2] = tmp;
+        i = (i - 1) / 2;
+    }
+}
+
+struct irq_request pending_pop() {
+    struct irq_request top = pending[0];
+    pending[0] = pending[--num_pending];
+    int i = 0;
+    while (1) {
+        int best = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < num_pending && irq_before(&pending[l], &pending[best]))
+            best = l;
+        if (r < num_pending && irq_before(&pending[r], &pending[best]))
+            best = r;
+        if (best == i)
+            break;
+        struct irq_request tmp = pending[i];
+        pending[i] = pending[best];
+        pending[best] = tmp;
+        i = best;
+    }
+    return top;
+}
+
+double exp_random(double mean) {
+    return -mean * log(1.0 - rand() / (RAND_MAX + 1.0));
+}
+
+/* start every pending request the current mask lets through */
+void irq_dispatch(double now) {
+    while (num_pending > 0 &&
+           !(level_mask[current_priority] & (1u << irq_sources[pending[0].source].priority))) {
+        struct irq_request req = pending_pop();
+        int level = irq_sources[req.source].priority;
+        double queueing = now - req.arrival;
+
+        if (nesting > 0)
+            level_stats[current_priority].preempted++;
+        level_stats[level].dispatched++;
+        level_stats[level].total_queueing += queueing;
+        if (queueing > level_stats[level].max_queueing)
+            level_stats[level].max_queueing = queueing;
+
+        req.start = now;
+        in_service[nesting++] = req;
+        current_priority = level;
+    }
+}
+
+int run_interrupt_controller(double sim_seconds, double storm, unsigned seed)
+{
+    double next_arrival[NUM_IRQ_SOURCES];
+    double end = sim_seconds * 1e6, now = 0;
+
+    /* a storm factor <= 0 would make arrivals run backwards and never reach end */
+    if (!(storm > 0)) {
+        fprintf(stderr, "storm factor must be greater than 0\n");
+        return 1;
+    }
+    srand(seed);
+    for (int l = 0; l < NUM_PRIORITY_LEVELS; l++)
+        level_mask[l] = (2u << l) - 1; /* level l blocks levels 0..l */
+    for (int s = 0; s < NUM_IRQ_SOURCES; s++)
+        next_arrival[s] = exp_random(irq_sources[s].mean_interarrival_us / storm);
+    current_priority = 0;
+
+    while (now < end) {
+        /* next event: an arrival or completion of the running handler */
+        int source = 0;
+        for (int s = 1; s < NUM_IRQ_SOURCES; s++)
+            if (next_arrival[s] < next_arrival[source])
+                source = s;
+        double next = next_arrival[source];
+        int completes = nesting > 0 && now + in_service[nesting - 1].remaining <= next;
+        if (completes)
+            next = now + in_service[nesting - 1].remaining;
+        if (nesting > 0)
+            in_service[nesting - 1].remaining -= next - now;
+        now = next;
+
+        if (completes) {
+            struct irq_request *done = &in_service[--nesting];
+            int level = irq_sources[done->source].priority;
+            double latency = now - done->arrival;
+            level_stats[level].serviced++;
+            level_stats[level].total_latency += latency;
+            if (latency > level_stats[level].max_latency)
+                level_stats[level].max_latency = latency;
+            current_priority = nesting > 0 ? irq_sources[in_service[nesting - 1].source].priority : 0;
+        } else {
+            struct irq_source *src = &irq_sources[source];
+            struct irq_request req = { source, now, -1,
+                                       src->service_us * (0.5 + rand() / (RAND_MAX + 1.0)) };
+            level_stats[src->priority].raised++;
+            if (num_pending == MAX_PENDING)
+                level_stats[src->priority].dropped++;
+            else
+                pending_push(req);
+            next_arrival[source] = now + exp_random(src->mean_interarrival_us / storm);
+        }
+        irq_dispatch(now);
+    }
+
+    printf("Interrupt controller: %.1f s simulated, storm factor %.1f, seed %u\n", sim_seconds, storm, seed);
+    printf("%5s %9s %9s %9s %8s %12s %12s %12s %12s\n", "LEVEL", "RAISED", "SERVICED", "PREEMPTED", "DROPPED",
+           "AVG_QUEUE_us", "MAX_QUEUE_us", "AVG_LAT_us", "MAX_LAT_us");
+    for (int l = NUM_PRIORITY_LEVELS - 1; l >= 1; l--) {
+        struct level_stats *st = &level_stats[l];
+        /* queueing is known at dispatch, latency only at completion */
+        long started = st->dispatched > 0 ? st->dispatched : 1;
+        long finished = st->serviced > 0 ? st->serviced : 1;
+        printf("%5d %9ld %9ld %9ld %8ld %12.1f %12.1f %12.1f %12.1f\n", l, st->raised, st->serviced,
+               st->preempted, st->dropped, st->total_queueing / started, st->max_queueing,
+               st->total_latency / finished, st->max_latency);
+    }
+    printf("Still pending: %d, still in service: %d\n", num_pending, nesting);
+    current_priority = 0;
+    return 0;
+}
+
+/*
+ * Delivery benchmark (-b). Generator threads fire SIGRTMIN with sigqueue,
+ * the payload carrying the send timestamp, and SIGUSR2 alongside it.
+ * Generators block both signals, so they are handled in the main thread.
+ * Real-time signals are queued one per send; standard signals coalesce
+ * while one is already pending, and the difference shows up as lost.
+ */
+struct generator {
+    pthread_t thread;
+    double rate;        /* signals per second of each kind */
+    double seconds;
+    long rt_sent, rt_rejected, std_sent;
+};
+
+long latency_hist[LATENCY_BUCKETS];
+volatile long rt_received = 0, std_received = 0;
+
+long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void rt_handler(int sig, siginfo_t *info, void *context) {
+    long long latency = now_ns() - (intptr_t)info->si_value.sival_ptr;
+    int b = 0;
+    while (b < LATENCY_BUCKETS - 1 && latency >= (2LL << b))
+        b++;
+    latency_hist[b]++;
+    rt_received++;
+}
+
+void std_handler(int sig) {
+    std_received++;
+}
+
+void *generator_thread(void *arg) {
+    struct generator *g = arg;
+    pid_t pid = getpid();
+    struct timespec next;
+    long long start = now_ns(), end = start + (long long)(g->seconds * 1e9);
+    double owed = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (now_ns() < end) {
+        /* catch up on whatever the rate says is due by now */
+        owed += g->rate * BURST_NS / 1e9;
+        for (; owed >= 1; owed--) {
+            union sigval value = { .sival_ptr = (void *)(intptr_t)now_ns() };
+            if (sigqueue(pid, SIGRTMIN, value) == 0)
+                g->rt_sent++;
+            else if (errno == EAGAIN)
+                g->rt_rejected++; /* RLIMIT_SIGPENDING reached */
+            if (kill(pid, SIGUSR2) == 0)
+                g->std_sent++;
+        }
+        next.tv_nsec += BURST_NS;
+        if (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return NULL;
+}
+
+int run_delivery_benchmark(double rate, double seconds, int threads, int json)
 {
+    struct generator gens[MAX_GENERATORS];
     struct sigaction act;
+    sigset_t mask;
+
+    if (threads < 1)
+        threads = 1;
+    if (threads > MAX_GENERATORS)
+        threads = MAX_GENERATORS;
+
+    act.sa_sigaction = rt_handler;
+    sigemptyset(&act.sa_mask);
+    act.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigaction(SIGRTMIN, &act, NULL);
+    act.sa_handler = std_handler;
+    act.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &act, NULL);
+
+    /* generators inherit this mask; the main thread unblocks afterwards */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGRTMIN);
+    sigaddset(&mask, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    for (int t = 0; t < threads; t++) {
+        gens[t] = (struct generator){ .rate = rate / threads, .seconds = seconds };
+        pthread_create(&gens[t].thread, NULL, generator_thread, &gens[t]);
+    }
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+
+    long rt_sent = 0, rt_rejected = 0, std_sent = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(gens[t].thread, NULL);
+        rt_sent += gens[t].rt_sent;
+        rt_rejected += gens[t].rt_rejected;
+        std_sent += gens[t].std_sent;
+    }
+    struct timespec drain = { 0, 100000000 }; /* let the last signals land */
+    nanosleep(&drain, NULL);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    long seen = 0, p50 = -1, p99 = -1;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += latency_hist[b];
+        if (p50 < 0 && seen * 2 >= rt_received)
+            p50 = b;
+        if (p99 < 0 && seen * 100 >= rt_received * 99)
+            p99 = b;
+    }
+
+    if (json) {
+        printf("{\"program\": \"signals\", \"benchmark\": \"signal_delivery\", \"seconds\": %.3f, "
+               "\"rate\": %.0f, \"threads\": %d, \"rt_sent\": %ld, \"rt_received\": %ld, "
+               "\"rt_rejected\": %ld, \"rt_per_sec\": %.0f, \"std_sent\": %ld, \"std_received\": %ld, "
+               "\"std_lost\": %ld, \"latency_p50_ns\": %lld, \"latency_p99_ns\": %lld}\n",
+               seconds, rate, threads, rt_sent, rt_received, rt_rejected, rt_received / seconds,
+               std_sent, std_received, std_sent - std_received,
+               p50 >= 0 ? 2LL << p50 : 0, p99 >= 0 ? 2LL << p99 : 0);
+        return 0;
+    }
+
+    printf("Delivery benchmark: %.0f signals/s of each kind, %.1f s, %d generator threads\n",
+           rate, seconds, threads);
+    printf("RT  (SIGRTMIN): sent %ld, received %ld, rejected with EAGAIN %ld\n",
+           rt_sent, rt_received, rt_rejected);
+    printf("STD (SIGUSR2):  sent %ld, received %ld, coalesced/lost %ld\n",
+           std_sent, std_received, std_sent - std_received);
+
+    printf("Send-to-handler latency (RT):\n");
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (latency_hist[b] > 0)
+            printf("  %9lld - %9lld ns: %ld\n", b == 0 ? 0 : 1LL << b, (2LL << b) - 1, latency_hist[b]);
+    }
+    if (rt_received > 0)
+        printf("  p50 < %lld ns, p99 < %lld ns\n", 2LL << p50, 2LL << p99);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct sigaction act;
+
+    srand(time(NULL));
+
+    /* -b [rate] [seconds] [threads]: sigqueue delivery-latency benchmark */
+    if (argc > 1 && strcmp(argv[1], "-b") == 0)
+        return run_delivery_benchmark(argc > 2 ? atof(argv[2]) : 10000.0,
+                                      argc > 3 ? atof(argv[3]) : 2.0,
+                                      argc > 4 ? atoi(argv[4]) : 2, 0);
+
+    /* --bench SECONDS [SEED]: fixed 100k/s delivery run, one JSON line out */
+    if (argc > 2 && strcmp(argv[1], "--bench") == 0) {
+        srand(argc > 3 ? (unsigned)atoi(argv[3]) : 1);
+        return run_delivery_benchmark(100000.0, atof(argv[2]), 2, 1);
+    }
+
+    /* -p [seconds] [storm factor] [seed]: simulated nested interrupt controller */
+    if (argc > 1 && strcmp(argv[1], "-p") == 0)
+        return run_interrupt_controller(argc > 2 ? atof(argv[2]) : 10.0,
+                                        argc > 3 ? atof(argv[3]) : 1.0,
+                                        argc > 4 ? (unsigned)atoi(argv[4]) : 1);
+
+    /* -e: signalfd/epoll event loop instead of work inside signal handlers */
+    if (argc > 1 && strcmp(argv[1], "-e") == 0)
+        return run_event_loop();
 
     /* 1. masking signal SIGUSR1 */
     /* signal handler function */
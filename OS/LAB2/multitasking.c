@@ -5,26 +5,173 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
 #include <termios.h>
 #include <fcntl.h>
+#include <spawn.h>
+#include <time.h>
 
 #define MAX_COMMAND_LENGTH 1024
 #define MAX_ARGS 64
+#define MAX_PIPELINE 16
+#define MAX_JOBS 64
+#define HASH_SIZE 256 // Slots in the command lookup cache (power of two)
+#define STATS_SIZE 64 // Distinct command names tracked by the stats builtin (power of two)
+#define STATS_WINDOW 128 // Most recent runs kept per command for the p99
 #define DELIMITERS " \t\n"
 
+// One command of a pipeline together with its redirections
+typedef struct {
+    char **argv;     // NULL-terminated, points into the shell's args[]
+    char *in_file;   // < file
+    char *out_file;  // > file or >> file
+    char *err_file;  // 2> file or 2>> file
+    int append;      // out_file was given with >>
+    int err_append;  // err_file was given with 2>>
+} Stage;
+
+typedef struct {
+    Stage stages[MAX_PIPELINE];
+    int num_stages;
+    int background;
+    int batch;       // Batch job: stdin from /dev/null, output left alone
+    int unstarted_status; // Set by spawn_pipeline if the last stage could not start:
+                          // 1 for a failed redirection, 126/127 for a failed exec
+} Pipeline;
+
+typedef enum { PROC_RUNNING, PROC_STOPPED, PROC_DONE } ProcState;
+
+typedef struct {
+    pid_t pid;
+    int stage;      // Index of the pipeline stage it runs
+    ProcState state;
+    int status;     // Last status reported by wait4
+    double end_us;  // When the process was reaped
+    struct rusage usage; // Resources used, valid once the process is done
+} Process;
+
+// Fixed-size job table: slots are recycled, so memory use does not grow with
+// the number of jobs a session launches.
+typedef struct {
+    int id;                 // 0 marks a free slot
+    pid_t pgid;             // Process group shared by all stages
+    Process procs[MAX_PIPELINE]; // Stages that started; failed ones are skipped
+    int num_procs;
+    int num_stages;         // Stages in the pipeline, started or not
+    int unstarted_status;   // Exit status to report if the last stage never started
+    int background;
+    int batch;              // Owned by run_batch, not reported at the prompt
+    int notified;           // User already told the job stopped
+    int timed;              // Started with the time builtin
+    double start_us;        // Launch time, for batch wall-time reports
+    unsigned long seq;      // Launch order, used to pick the "current" job
+    char command[MAX_COMMAND_LENGTH];
+} Job;
+
+// Cached PATH lookup: command name -> absolute path of the executable
+typedef struct {
+    char *name;     // NULL marks an empty slot
+    char *path;
+    unsigned hits;
+} HashEntry;
+
+// Rolling statistics for one command name
+typedef struct {
+    char name[64];                 // Empty marks a free slot
+    unsigned long count;
+    double total_wall;             // Seconds, over all runs
+    double total_cpu;
+    long max_rss_kb;
+    float recent_wall[STATS_WINDOW]; // Ring of the latest wall times
+} CommandStats;
+
+// Resources used by a whole job, summed over its processes
+typedef struct {
+    double wall, user, sys;        // Seconds
+    long max_rss_kb;               // Largest single process
+    long minor_faults, major_faults;
+    long voluntary_switches, involuntary_switches;
+} JobUsage;
+
 void execute_command(char *command, char *args[]);
 void parse_command(char *command, char *args[]);
+int parse_pipeline(char *args[], Pipeline *pipeline);
+int spawn_pipeline(Pipeline *pipeline, pid_t pids[], int stages[]);
+Job *start_job(Pipeline *pipeline, const char *command);
+void launch_job(Pipeline *pipeline, const char *command, int timed);
+void finish_job(Job *job);
+void job_usage(Job *job, JobUsage *usage);
+void record_command_stats(const char *command, JobUsage *usage);
+void list_command_stats();
+int run_batch(const char *file, int max_jobs);
+Job *find_job(const char *spec);
+int job_is_completed(Job *job);
+int job_is_stopped(Job *job);
+void wait_for_job(Job *job);
+void put_job_in_foreground(Job *job, int cont);
+void put_job_in_background(Job *job, int cont);
+void do_job_notification();
+void list_jobs();
+void list_processes(int show_all);
+const char *lookup_command(const char *name);
+void hash_forget(const char *name);
+void hash_clear();
+void hash_list();
+void spawn_benchmark(int iterations, int ballast_mb);
+int spawn_benchmark_json(double seconds);
+int signame_to_signum(const char *signame);
 void sigint_handler(int sig);
 void sigterm_handler(int sig);
+void sigchld_handler(int sig);
+static double now_us();
+static unsigned hash_name(const char *name);
 
 pid_t shell_pgid; // Store the process group ID of the shell
+int shell_terminal = STDIN_FILENO;
+int shell_is_interactive;
+struct termios shell_tmodes;
+
+Job jobs[MAX_JOBS];
+unsigned long job_seq;
+sigset_t sigchld_set; // Just SIGCHLD; blocked whenever the job table is touched
+
+HashEntry command_hash[HASH_SIZE];
+int command_hash_count;
+char *hashed_path_env; // PATH the cache was built for
+
+CommandStats command_stats[STATS_SIZE];
 
-int main()
+int main(int argc, char *argv[])
 {
     char command[MAX_COMMAND_LENGTH];
     char *args[MAX_ARGS];
     char cwd[1024]; // buffer to store current working directory
+    int max_jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    // Usage: multitasking [-j jobs] [script]; with a script, run it in batch mode
+    //        multitasking --bench seconds; headless spawn-latency benchmark
+    int bench = argc > 2 && strcmp(argv[1], "--bench") == 0;
+    while (!bench && (opt = getopt(argc, argv, "j:")) != -1)
+    {
+        if (opt == 'j')
+        {
+            max_jobs = atoi(optarg);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-j jobs] [script]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (max_jobs < 1)
+    {
+        max_jobs = 1;
+    }
 
     struct sigaction sigint_action, sigterm_action;
     sigint_action.sa_handler = sigint_handler;
@@ -37,10 +184,40 @@ int main()
     sigterm_action.sa_flags = 0;
     sigaction(SIGTERM, &sigterm_action, NULL);
 
+    // Children are reaped asynchronously; SA_RESTART keeps fgets from failing with EINTR
+    struct sigaction sigchld_action;
+    sigchld_action.sa_handler = sigchld_handler;
+    sigemptyset(&sigchld_action.sa_mask);
+    sigchld_action.sa_flags = SA_RESTART;
+    sigaction(SIGCHLD, &sigchld_action, NULL);
+    sigemptyset(&sigchld_set);
+    sigaddset(&sigchld_set, SIGCHLD);
+
     shell_pgid = getpgrp(); // Get the process group ID of the shell
+    if (bench)
+    {
+        return spawn_benchmark_json(atof(argv[2]));
+    }
+    if (optind < argc)
+    {
+        return run_batch(argv[optind], max_jobs);
+    }
+
+    shell_is_interactive = isatty(shell_terminal);
+    if (shell_is_interactive)
+    {
+        // Job control: the shell hands the terminal to foreground jobs and takes it back
+        signal(SIGTSTP, SIG_IGN);
+        signal(SIGTTIN, SIG_IGN);
+        signal(SIGTTOU, SIG_IGN);
+        tcsetpgrp(shell_terminal, shell_pgid);
+        tcgetattr(shell_terminal, &shell_tmodes);
+    }
 
     while (1)
     {
+        do_job_notification();
+
         if (getcwd(cwd, sizeof(cwd)) != NULL)
         {
             printf("%s> ", cwd); // Display current working directory
@@ -71,9 +248,7 @@ int main()
             }
             else if (strcmp(args[0], "ps") == 0)
             {
-                char ps_command[MAX_COMMAND_LENGTH];
-                sprintf(ps_command, "/bin/ps -eo pid,comm,pgid | grep %d", shell_pgid);
-                system(ps_command);
+                list_processes(args[1] != NULL && strcmp(args[1], "-a") == 0);
             }
             else if (strcmp(args[0], "cd") == 0)
             {
@@ -99,8 +274,14 @@ int main()
                 {
                     int pid;
                     char *signal = NULL;
+                    // Like kill(1), send SIGTERM when no signal is named
+                    if (args[2] == NULL)
+                    {
+                        pid = atoi(args[1]);
+                        signal = "SIGTERM";
+                    }
                     // Check if SIGINT is explicitly mentioned in the command
-                    if (strcmp(args[2], "SIGINT") == 0)
+                    else if (strcmp(args[2], "SIGINT") == 0)
                     {
                         pid = atoi(args[1]);
                         signal = "SIGINT";
@@ -116,7 +297,7 @@ int main()
                     if (pgid == -1)
                     {
                         perror("getpgid");
-                        return;
+                        continue;
                     }
 
                     // Send the signal to the process group
@@ -135,65 +316,116 @@ int main()
                 }
             }
 
-            else
+            else if (strcmp(args[0], "spawnbench") == 0)
+            {
+                int iterations = args[1] != NULL ? atoi(args[1]) : 1000;
+                int ballast_mb = (args[1] != NULL && args[2] != NULL) ? atoi(args[2]) : 0;
+                spawn_benchmark(iterations, ballast_mb);
+            }
+            else if (strcmp(args[0], "hash") == 0)
             {
-                // Check if the command should be run in the background
-                int run_in_background = 0;
-                int i;
-                for (i = 0; args[i] != NULL; i++)
+                if (args[1] == NULL)
                 {
-                    if (strcmp(args[i], "&") == 0)
-                    {
-                        run_in_background = 1;
-                        args[i] = NULL; // Remove '&' from arguments
-                        break;
-                    }
+                    hash_list();
                 }
-
-                // Fork a child process to execute the command
-                pid_t pid = fork();
-                if (pid == 0)
+                else if (strcmp(args[1], "-r") == 0)
                 {
-                    // Child process
-                    if (run_in_background)
-                    {
-                        // Set the child process group ID to the shell's process group ID
-                        setpgid(0, shell_pgid);
-                        // Redirect input from /dev/null
-                        int fd = open("/dev/null", O_RDONLY);
-                        dup2(fd, STDIN_FILENO);
-                        close(fd);
-                        // Redirect output and error to /dev/null
-                        fd = open("/dev/null", O_WRONLY);
-                        dup2(fd, STDOUT_FILENO);
-                        dup2(fd, STDERR_FILENO);
-                        close(fd);
-                    }
-                    if (execvp(args[0], args) == -1)
+                    hash_clear();
+                }
+                else
+                {
+                    for (int i = 1; args[i] != NULL; i++)
                     {
-                        perror("execvp");
-                        exit(EXIT_FAILURE);
+                        if (lookup_command(args[i]) == NULL)
+                        {
+                            fprintf(stderr, "hash: %s: not found\n", args[i]);
+                        }
                     }
                 }
-                else if (pid < 0)
+            }
+            else if (strcmp(args[0], "time") == 0)
+            {
+                Pipeline pipeline;
+                if (args[1] == NULL)
+                {
+                    fprintf(stderr, "time: missing command\n");
+                }
+                else if (parse_pipeline(args + 1, &pipeline) == 0)
+                {
+                    // The job keeps the whole line; its stats key skips the "time" prefix
+                    launch_job(&pipeline, command + strspn(command, DELIMITERS), 1);
+                }
+            }
+            else if (strcmp(args[0], "stats") == 0)
+            {
+                if (args[1] != NULL && strcmp(args[1], "-r") == 0)
+                {
+                    memset(command_stats, 0, sizeof(command_stats));
+                }
+                else
+                {
+                    list_command_stats();
+                }
+            }
+            else if (strcmp(args[0], "jobs") == 0)
+            {
+                list_jobs();
+            }
+            else if (strcmp(args[0], "fg") == 0 || strcmp(args[0], "bg") == 0)
+            {
+                sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+                Job *job = find_job(args[1]);
+                if (job == NULL)
+                {
+                    fprintf(stderr, "%s: no such job\n", args[0]);
+                }
+                else if (args[0][0] == 'f')
                 {
-                    // Fork failed
-                    perror("fork");
+                    printf("%s\n", job->command);
+                    put_job_in_foreground(job, 1);
                 }
                 else
                 {
-                    // Parent process
-                    if (!run_in_background)
+                    printf("[%d] %s &\n", job->id, job->command);
+                    put_job_in_background(job, 1);
+                }
+                sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
+            }
+            else if (strcmp(args[0], "wait") == 0)
+            {
+                sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+                if (args[1] != NULL)
+                {
+                    Job *job = find_job(args[1]);
+                    if (job == NULL)
                     {
-                        // Wait for the child process to finish if it's not running in the background
-                        waitpid(pid, NULL, 0);
+                        fprintf(stderr, "wait: no such job\n");
                     }
                     else
                     {
-                        // Print the background process ID
-                        printf("Background process started with PID %d\n", pid);
+                        wait_for_job(job);
                     }
                 }
+                else
+                {
+                    for (int i = 0; i < MAX_JOBS; i++)
+                    {
+                        if (jobs[i].id != 0 && jobs[i].background)
+                        {
+                            wait_for_job(&jobs[i]);
+                        }
+                    }
+                }
+                sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
+            }
+            else
+            {
+                Pipeline pipeline;
+                if (parse_pipeline(args, &pipeline) != 0)
+                {
+                    continue;
+                }
+                launch_job(&pipeline, command, 0);
             }
         }
     }
@@ -203,8 +435,54 @@ int main()
 
 void parse_command(char *command, char *args[])
 {
+    // Operators may be written without surrounding spaces ("ls|wc", "cat<in"),
+    // so pad them out first and let strtok split on whitespace as usual.
+    static char expanded[3 * MAX_COMMAND_LENGTH];
+    size_t j = 0;
+    for (size_t k = 0; command[k] != '\0' && j < sizeof(expanded) - 5; k++)
+    {
+        char c = command[k];
+        int at_token_start = (k == 0 || strchr(DELIMITERS, command[k - 1]) != NULL);
+        if (c == '2' && command[k + 1] == '>' && command[k + 2] == '>' && at_token_start)
+        {
+            expanded[j++] = ' ';
+            expanded[j++] = '2';
+            expanded[j++] = '>';
+            expanded[j++] = '>';
+            expanded[j++] = ' ';
+            k += 2;
+        }
+        else if (c == '2' && command[k + 1] == '>' && at_token_start)
+        {
+            expanded[j++] = ' ';
+            expanded[j++] = '2';
+            expanded[j++] = '>';
+            expanded[j++] = ' ';
+            k++;
+        }
+        else if (c == '>' && command[k + 1] == '>')
+        {
+            expanded[j++] = ' ';
+            expanded[j++] = '>';
+            expanded[j++] = '>';
+            expanded[j++] = ' ';
+            k++;
+        }
+        else if (c == '|' || c == '<' || c == '>' || c == '&')
+        {
+            expanded[j++] = ' ';
+            expanded[j++] = c;
+            expanded[j++] = ' ';
+        }
+        else
+        {
+            expanded[j++] = c;
+        }
+    }
+    expanded[j] = '\0';
+
     int i = 0;
-    args[i] = strtok(command, DELIMITERS);
+    args[i] = strtok(expanded, DELIMITERS);
     while (args[i] != NULL && i < MAX_ARGS - 1)
     {
         i++;
@@ -213,21 +491,1253 @@ void parse_command(char *command, char *args[])
     args[i] = NULL; // Null-terminate the argument list
 }
 
-void sigint_handler(int sig)
+// Split the token list into pipeline stages and pull out redirections.
+// Stage argv arrays point into args[], which is compacted in place.
+int parse_pipeline(char *args[], Pipeline *pipeline)
 {
-    printf("Received SIGINT.\n");
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->num_stages = 1;
+    Stage *stage = &pipeline->stages[0];
+    stage->argv = &args[0];
+
+    int w = 0;
+    for (int r = 0; args[r] != NULL; r++)
+    {
+        char *tok = args[r];
+        if (strcmp(tok, "&") == 0)
+        {
+            pipeline->background = 1;
+            break; // Anything after '&' is ignored
+        }
+        else if (strcmp(tok, "|") == 0)
+        {
+            if (stage->argv == &args[w] || pipeline->num_stages == MAX_PIPELINE)
+            {
+                fprintf(stderr, "syntax error near '|'\n");
+                return -1;
+            }
+            args[w++] = NULL; // Terminate the current stage's argv
+            stage = &pipeline->stages[pipeline->num_stages++];
+            stage->argv = &args[w];
+        }
+        else if (strcmp(tok, "<") == 0 || strcmp(tok, ">") == 0 ||
+                 strcmp(tok, ">>") == 0 || strcmp(tok, "2>") == 0 || strcmp(tok, "2>>") == 0)
+        {
+            char *file = args[r + 1];
+            if (file == NULL || strchr("|<>&", file[0]) != NULL)
+            {
+                fprintf(stderr, "syntax error: missing file after '%s'\n", tok);
+                return -1;
+            }
+            if (tok[0] == '<')
+            {
+                stage->in_file = file;
+            }
+            else if (tok[0] == '2')
+            {
+                stage->err_file = file;
+                stage->err_append = (tok[2] == '>');
+            }
+            else
+            {
+                stage->out_file = file;
+                stage->append = (tok[1] == '>');
+            }
+            r++; // Skip the file name
+        }
+        else
+        {
+            args[w++] = tok;
+        }
+    }
+    args[w] = NULL;
+
+    if (stage->argv[0] == NULL)
+    {
+        if (pipeline->num_stages > 1)
+        {
+            fprintf(stderr, "syntax error near '|'\n");
+        }
+        return -1;
+    }
+    return 0;
 }
 
-void sigterm_handler(int sig)
+// Open a < > >> 2> or 2>> target for a stage. Returns 1 if there was nothing to open
+// or it opened, 0 (after reporting the file) if it could not be opened.
+static int open_redirection(const char *file, int flags, int *fd)
 {
-    printf("Received SIGTERM.\n");
+    if (file == NULL)
+    {
+        return 1;
+    }
+    *fd = open(file, flags | O_CLOEXEC, 0644);
+    if (*fd == -1)
+    {
+        fprintf(stderr, "%s: %s\n", file, strerror(errno));
+        return 0;
+    }
+    return 1;
 }
-// Function to convert signal name to signal number
-int signame_to_signum(const char *signame)
+
+// Launch every stage of the pipeline with posix_spawn. glibc implements it with
+// clone(CLONE_VM | CLONE_VFORK), so a large shell does not pay for copying its
+// page tables the way fork() does. Returns the number of processes started;
+// stages[] receives the stage index of each one.
+int spawn_pipeline(Pipeline *pipeline, pid_t pids[], int stages[])
 {
-    if (strcmp(signame, "SIGINT") == 0)
+    extern char **environ;
+    int spawned = 0;
+    int prev_read = -1; // Read end of the pipe feeding the current stage
+
+    // Every stage joins one new process group (led by the first stage) so the
+    // job can be stopped, continued and signalled as a unit. Signals the shell
+    // ignores or blocks must not leak into the children.
+    posix_spawnattr_t attr;
+    sigset_t default_signals, empty_mask;
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGINT);
+    sigaddset(&default_signals, SIGTERM);
+    sigaddset(&default_signals, SIGCHLD);
+    sigaddset(&default_signals, SIGTSTP);
+    sigaddset(&default_signals, SIGTTIN);
+    sigaddset(&default_signals, SIGTTOU);
+    sigemptyset(&empty_mask);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+    posix_spawnattr_setsigdefault(&attr, &default_signals);
+    posix_spawnattr_setsigmask(&attr, &empty_mask);
+
+    for (int i = 0; i < pipeline->num_stages; i++)
     {
-        return SIGINT; // Manual mapping for SIGINT
+        Stage *stage = &pipeline->stages[i];
+        int is_first = (i == 0);
+        int is_last = (i == pipeline->num_stages - 1);
+        int pipe_fds[2] = {-1, -1};
+
+        // Pipe ends are close-on-exec; only the dup2'ed copies survive into the child
+        if (!is_last && pipe2(pipe_fds, O_CLOEXEC) != 0)
+        {
+            perror("pipe");
+            break;
+        }
+
+        // Redirection files are opened by the shell, not with addopen, so that a
+        // failure is reported against the file rather than the command. The
+        // files are opened in order and the first failure skips the rest.
+        int redirect_fds[3] = {-1, -1, -1};
+        int out_flags = O_WRONLY | O_CREAT | (stage->append ? O_APPEND : O_TRUNC);
+        int err_flags = O_WRONLY | O_CREAT | (stage->err_append ? O_APPEND : O_TRUNC);
+        int redirected = open_redirection(stage->in_file, O_RDONLY, &redirect_fds[STDIN_FILENO]) &&
+                         open_redirection(stage->out_file, out_flags, &redirect_fds[STDOUT_FILENO]) &&
+                         open_redirection(stage->err_file, err_flags, &redirect_fds[STDERR_FILENO]);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+
+        if (redirect_fds[STDIN_FILENO] != -1)
+        {
+            posix_spawn_file_actions_adddup2(&actions, redirect_fds[STDIN_FILENO], STDIN_FILENO);
+        }
+        else if (prev_read != -1)
+        {
+            posix_spawn_file_actions_adddup2(&actions, prev_read, STDIN_FILENO);
+        }
+        else if (is_first && (pipeline->background || pipeline->batch))
+        {
+            // Redirect input from /dev/null
+            posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        }
+
+        if (redirect_fds[STDOUT_FILENO] != -1)
+        {
+            posix_spawn_file_actions_adddup2(&actions, redirect_fds[STDOUT_FILENO], STDOUT_FILENO);
+        }
+        else if (!is_last)
+        {
+            posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+        }
+        else if (pipeline->background)
+        {
+            // Redirect output to /dev/null
+            posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        }
+
+        if (redirect_fds[STDERR_FILENO] != -1)
+        {
+            posix_spawn_file_actions_adddup2(&actions, redirect_fds[STDERR_FILENO], STDERR_FILENO);
+        }
+        else if (pipeline->background)
+        {
+            // Redirect error to /dev/null
+            posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+        }
+
+        pid_t pid;
+        int err = -1; // A failed redirection has already been reported
+        posix_spawnattr_setpgroup(&attr, spawned > 0 ? pids[0] : 0);
+        const char *path = redirected ? lookup_command(stage->argv[0]) : NULL;
+        if (redirected)
+        {
+            err = path != NULL ? posix_spawn(&pid, path, &actions, &attr, stage->argv, environ) : ENOENT;
+        }
+        if ((err == ENOENT || err == EACCES) && path != NULL && strchr(stage->argv[0], '/') == NULL &&
+            access(path, X_OK) != 0)
+        {
+            // The cached location went stale (binary moved or removed); search PATH again.
+            // Other ENOENT/EACCES causes, such as a missing interpreter, are not retried.
+            hash_forget(stage->argv[0]);
+            path = lookup_command(stage->argv[0]);
+            err = path != NULL ? posix_spawn(&pid, path, &actions, &attr, stage->argv, environ) : ENOENT;
+        }
+        posix_spawn_file_actions_destroy(&actions);
+        for (int fd = 0; fd < 3; fd++)
+        {
+            if (redirect_fds[fd] != -1)
+            {
+                close(redirect_fds[fd]);
+            }
+        }
+
+        if (prev_read != -1)
+        {
+            close(prev_read);
+        }
+        if (pipe_fds[1] != -1)
+        {
+            close(pipe_fds[1]);
+        }
+        prev_read = pipe_fds[0];
+
+        if (err != 0)
+        {
+            if (err > 0)
+            {
+                fprintf(stderr, "%s: %s\n", stage->argv[0], strerror(err));
+            }
+            if (i == pipeline->num_stages - 1)
+            {
+                pipeline->unstarted_status = err < 0 ? 1 : err == EACCES ? 126 : 127;
+            }
+            continue; // Downstream stages still run and see EOF on their input
+        }
+        stages[spawned] = i;
+        pids[spawned++] = pid;
+    }
+
+    if (prev_read != -1)
+    {
+        close(prev_read);
+    }
+    posix_spawnattr_destroy(&attr);
+    return spawned;
+}
+
+// Spawn a pipeline and record it in a free job slot. The caller must hold
+// SIGCHLD blocked, otherwise a fast child could be reaped before we know
+// which job it belongs to. Returns NULL if nothing could be started.
+Job *start_job(Pipeline *pipeline, const char *command)
+{
+    pid_t pids[MAX_PIPELINE];
+    int stages[MAX_PIPELINE];
+    Job *job = NULL;
+
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        if (jobs[i].id == 0)
+        {
+            job = &jobs[i];
+            break;
+        }
+    }
+    if (job == NULL)
+    {
+        fprintf(stderr, "too many jobs (limit %d)\n", MAX_JOBS);
+        return NULL;
+    }
+
+    double start = now_us();
+    int spawned = spawn_pipeline(pipeline, pids, stages);
+    if (spawned == 0)
+    {
+        return NULL;
+    }
+
+    memset(job, 0, sizeof(*job));
+    job->id = (int)(job - jobs) + 1;
+    job->pgid = pids[0];
+    job->num_procs = spawned;
+    job->num_stages = pipeline->num_stages;
+    job->unstarted_status = pipeline->unstarted_status;
+    job->background = pipeline->background;
+    job->batch = pipeline->batch;
+    job->seq = ++job_seq;
+    job->start_us = start;
+    for (int i = 0; i < spawned; i++)
+    {
+        job->procs[i].pid = pids[i];
+        job->procs[i].stage = stages[i];
+        job->procs[i].state = PROC_RUNNING;
+    }
+    strncpy(job->command, command, sizeof(job->command) - 1);
+    return job;
+}
+
+// Start a pipeline typed at the prompt. The caller must not hold SIGCHLD blocked.
+void launch_job(Pipeline *pipeline, const char *command, int timed)
+{
+    sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+    Job *job = start_job(pipeline, command);
+    if (job != NULL)
+    {
+        job->timed = timed;
+    }
+
+    if (job == NULL)
+    {
+        // Nothing to wait for
+    }
+    else if (!job->background)
+    {
+        put_job_in_foreground(job, 0);
+    }
+    else
+    {
+        // Print the job number and the process group ID
+        printf("[%d] %d\n", job->id, job->pgid);
+    }
+    sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
+}
+
+// Exit status of a finished job as a shell would report it ($?): that of the
+// last stage, 128 + signal number if it was killed, or the reason it never
+// started (1 for a failed redirection, 126/127 for a failed exec)
+static int job_exit_status(Job *job)
+{
+    Process *last = &job->procs[job->num_procs - 1];
+    if (last->stage != job->num_stages - 1)
+    {
+        return job->unstarted_status;
+    }
+    int status = last->status;
+    if (WIFEXITED(status))
+    {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status))
+    {
+        return 128 + WTERMSIG(status);
+    }
+    return 1;
+}
+
+// One line of the batch report; usage is NULL for lines that never started
+static void print_batch_result(int exit_status, JobUsage *usage, const char *command)
+{
+    JobUsage none;
+    if (usage == NULL)
+    {
+        memset(&none, 0, sizeof(none));
+        usage = &none;
+    }
+    printf("[batch] exit=%-3d %9.3fs  cpu %7.3fs  rss %7ldKB  %s\n", exit_status,
+           usage->wall, usage->user + usage->sys, usage->max_rss_kb, command);
+}
+
+// SIGINT/SIGTERM received while a batch runs, and how many times
+static volatile sig_atomic_t batch_signal;
+static volatile sig_atomic_t batch_signal_count;
+
+static void batch_signal_handler(int sig)
+{
+    batch_signal = sig;
+    batch_signal_count++;
+}
+
+// Batch mode: run every line of a command file as an independent job, keeping
+// at most max_jobs of them running at once (like make -j or xargs -P). Each
+// command's exit status and wall time are reported as it finishes.
+// Batch jobs live in their own process groups, so a SIGINT or SIGTERM aimed at
+// the runner is passed on to every running job and no further lines are
+// started; a second signal escalates to SIGKILL.
+int run_batch(const char *file, int max_jobs)
+{
+    FILE *input = strcmp(file, "-") == 0 ? stdin : fopen(file, "r");
+    if (input == NULL)
+    {
+        perror(file);
+        return 2;
+    }
+    if (max_jobs > MAX_JOBS)
+    {
+        max_jobs = MAX_JOBS;
+    }
+
+    char command[MAX_COMMAND_LENGTH];
+    char *args[MAX_ARGS];
+    int running = 0, total = 0, failed = 0, eof = 0, forwarded = 0;
+    double batch_start = now_us();
+    sigset_t block_mask, wait_mask;
+
+    struct sigaction stop_action, old_int_action, old_term_action;
+    stop_action.sa_handler = batch_signal_handler;
+    sigemptyset(&stop_action.sa_mask);
+    stop_action.sa_flags = 0;
+    sigaction(SIGINT, &stop_action, &old_int_action);
+    sigaction(SIGTERM, &stop_action, &old_term_action);
+
+    // The loop only sleeps in sigsuspend, so none of these can slip past a check
+    block_mask = sigchld_set;
+    sigaddset(&block_mask, SIGINT);
+    sigaddset(&block_mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &block_mask, &wait_mask);
+    sigdelset(&wait_mask, SIGCHLD);
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGTERM);
+    while (!eof || running > 0)
+    {
+        if (batch_signal_count > forwarded)
+        {
+            int sig = forwarded == 0 ? batch_signal : SIGKILL;
+            for (int i = 0; i < MAX_JOBS; i++)
+            {
+                if (jobs[i].id != 0 && jobs[i].batch && !job_is_completed(&jobs[i]))
+                {
+                    kill(-jobs[i].pgid, sig);
+                }
+            }
+            forwarded = batch_signal_count;
+            eof = 1; // Start nothing new
+        }
+
+        // Fill the free job slots
+        while (!eof && running < max_jobs)
+        {
+            if (fgets(command, sizeof(command), input) == NULL)
+            {
+                eof = 1;
+                break;
+            }
+            command[strcspn(command, "\n")] = 0;
+            parse_command(command, args);
+            if (args[0] == NULL || args[0][0] == '#')
+            {
+                continue; // Blank line or comment
+            }
+
+            Pipeline pipeline;
+            if (parse_pipeline(args, &pipeline) != 0)
+            {
+                total++;
+                failed++;
+                print_batch_result(2, NULL, command);
+                continue;
+            }
+            pipeline.background = 0;
+            pipeline.batch = 1;
+
+            total++;
+            if (start_job(&pipeline, command) == NULL)
+            {
+                failed++;
+                print_batch_result(pipeline.unstarted_status != 0 ? pipeline.unstarted_status : 127,
+                                   NULL, command);
+                continue;
+            }
+            running++;
+        }
+
+        if (running == 0)
+        {
+            continue;
+        }
+
+        // Report whatever has finished; sleep until SIGCHLD if nothing has
+        int reaped = 0;
+        for (int i = 0; i < MAX_JOBS; i++)
+        {
+            Job *job = &jobs[i];
+            if (job->id == 0 || !job->batch || !job_is_completed(job))
+            {
+                continue;
+            }
+            int exit_status = job_exit_status(job);
+            JobUsage usage;
+            job_usage(job, &usage);
+            print_batch_result(exit_status, &usage, job->command);
+            failed += (exit_status != 0);
+            finish_job(job);
+            running--;
+            reaped++;
+        }
+        if (reaped == 0)
+        {
+            fflush(stdout);
+            sigsuspend(&wait_mask);
+        }
+    }
+    sigprocmask(SIG_UNBLOCK, &block_mask, NULL);
+    sigaction(SIGINT, &old_int_action, NULL);
+    sigaction(SIGTERM, &old_term_action, NULL);
+
+    if (input != stdin)
+    {
+        fclose(input);
+    }
+    printf("[batch] %d commands, %d failed, %d parallel, %.3fs total\n",
+           total, failed, max_jobs, (now_us() - batch_start) / 1e6);
+    if (batch_signal != 0)
+    {
+        printf("[batch] stopped by %s\n", strsignal(batch_signal));
+        return 128 + batch_signal;
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+static double timeval_seconds(struct timeval tv)
+{
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void job_usage(Job *job, JobUsage *usage)
+{
+    double end = job->start_us;
+    memset(usage, 0, sizeof(*usage));
+    for (int i = 0; i < job->num_procs; i++)
+    {
+        struct rusage *ru = &job->procs[i].usage;
+        usage->user += timeval_seconds(ru->ru_utime);
+        usage->sys += timeval_seconds(ru->ru_stime);
+        if (ru->ru_maxrss > usage->max_rss_kb)
+        {
+            usage->max_rss_kb = ru->ru_maxrss;
+        }
+        usage->minor_faults += ru->ru_minflt;
+        usage->major_faults += ru->ru_majflt;
+        usage->voluntary_switches += ru->ru_nvcsw;
+        usage->involuntary_switches += ru->ru_nivcsw;
+        if (job->procs[i].end_us > end)
+        {
+            end = job->procs[i].end_us;
+        }
+    }
+    usage->wall = (end - job->start_us) / 1e6;
+}
+
+// Account a completed job, print its time report if asked for, and free its slot
+void finish_job(Job *job)
+{
+    JobUsage usage;
+    job_usage(job, &usage);
+
+    const char *command = job->command;
+    if (job->timed)
+    {
+        command += strlen("time");
+        command += strspn(command, DELIMITERS);
+        printf("\nreal\t%.3fs\nuser\t%.3fs\nsys\t%.3fs\n", usage.wall, usage.user, usage.sys);
+        printf("maxrss\t%ldKB\nfaults\t%ld minor, %ld major\nctxsw\t%ld voluntary, %ld involuntary\n",
+               usage.max_rss_kb, usage.minor_faults, usage.major_faults,
+               usage.voluntary_switches, usage.involuntary_switches);
+    }
+    record_command_stats(command, &usage);
+    job->id = 0;
+}
+
+// Fold one run into the statistics of the command's first word
+void record_command_stats(const char *command, JobUsage *usage)
+{
+    char name[sizeof(command_stats[0].name)];
+    command += strspn(command, DELIMITERS);
+    size_t len = strcspn(command, " \t\n|<>&");
+    if (len == 0)
+    {
+        return;
+    }
+    if (len >= sizeof(name))
+    {
+        len = sizeof(name) - 1;
+    }
+    memcpy(name, command, len);
+    name[len] = '\0';
+
+    unsigned start = hash_name(name) & (STATS_SIZE - 1);
+    unsigned i = start;
+    while (command_stats[i].name[0] != '\0' && strcmp(command_stats[i].name, name) != 0)
+    {
+        i = (i + 1) & (STATS_SIZE - 1);
+        if (i == start)
+        {
+            return; // Table full; new command names are not tracked
+        }
+    }
+
+    CommandStats *stats = &command_stats[i];
+    strcpy(stats->name, name);
+    stats->recent_wall[stats->count % STATS_WINDOW] = (float)usage->wall;
+    stats->count++;
+    stats->total_wall += usage->wall;
+    stats->total_cpu += usage->user + usage->sys;
+    if (usage->max_rss_kb > stats->max_rss_kb)
+    {
+        stats->max_rss_kb = usage->max_rss_kb;
+    }
+}
+
+static int compare_float(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+void list_command_stats()
+{
+    printf("%-20s %8s %10s %10s %10s %10s\n", "COMMAND", "COUNT", "MEAN(ms)", "P99(ms)", "CPU(ms)", "MAXRSS(KB)");
+    for (int i = 0; i < STATS_SIZE; i++)
+    {
+        CommandStats *stats = &command_stats[i];
+        if (stats->name[0] == '\0')
+        {
+            continue;
+        }
+
+        // p99 over the rolling window of recent runs
+        float sorted[STATS_WINDOW];
+        int n = stats->count < STATS_WINDOW ? (int)stats->count : STATS_WINDOW;
+        memcpy(sorted, stats->recent_wall, n * sizeof(float));
+        qsort(sorted, n, sizeof(float), compare_float);
+        int p99_index = (99 * n + 99) / 100 - 1;
+
+        printf("%-20s %8lu %10.3f %10.3f %10.3f %10ld\n", stats->name, stats->count,
+               1e3 * stats->total_wall / stats->count, 1e3 * sorted[p99_index],
+               1e3 * stats->total_cpu / stats->count, stats->max_rss_kb);
+    }
+}
+
+// Look up a job by "%n" or "n"; with no spec, the most recently launched job
+Job *find_job(const char *spec)
+{
+    Job *best = NULL;
+    if (spec != NULL)
+    {
+        int id = atoi(spec[0] == '%' ? spec + 1 : spec);
+        if (id >= 1 && id <= MAX_JOBS && jobs[id - 1].id != 0)
+        {
+            return &jobs[id - 1];
+        }
+        return NULL;
+    }
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        if (jobs[i].id != 0 && (best == NULL || jobs[i].seq > best->seq))
+        {
+            best = &jobs[i];
+        }
+    }
+    return best;
+}
+
+int job_is_completed(Job *job)
+{
+    for (int i = 0; i < job->num_procs; i++)
+    {
+        if (job->procs[i].state != PROC_DONE)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int job_is_stopped(Job *job)
+{
+    int stopped = 0;
+    for (int i = 0; i < job->num_procs; i++)
+    {
+        if (job->procs[i].state == PROC_RUNNING)
+        {
+            return 0;
+        }
+        stopped |= (job->procs[i].state == PROC_STOPPED);
+    }
+    return stopped;
+}
+
+// Sleep until the job finishes or stops. Called with SIGCHLD blocked; the
+// handler does the actual reaping while we sit in sigsuspend.
+void wait_for_job(Job *job)
+{
+    sigset_t wait_mask;
+    sigprocmask(SIG_BLOCK, NULL, &wait_mask);
+    sigdelset(&wait_mask, SIGCHLD);
+    while (!job_is_completed(job) && !job_is_stopped(job))
+    {
+        sigsuspend(&wait_mask);
+    }
+}
+
+void put_job_in_foreground(Job *job, int cont)
+{
+    job->background = 0;
+    if (shell_is_interactive)
+    {
+        tcsetpgrp(shell_terminal, job->pgid);
+    }
+    if (cont)
+    {
+        for (int i = 0; i < job->num_procs; i++)
+        {
+            if (job->procs[i].state == PROC_STOPPED)
+            {
+                job->procs[i].state = PROC_RUNNING;
+            }
+        }
+        job->notified = 0;
+        if (kill(-job->pgid, SIGCONT) != 0)
+        {
+            perror("kill (SIGCONT)");
+        }
+    }
+
+    wait_for_job(job);
+
+    if (shell_is_interactive)
+    {
+        // Take the terminal back and undo whatever modes the job left behind
+        tcsetpgrp(shell_terminal, shell_pgid);
+        tcsetattr(shell_terminal, TCSADRAIN, &shell_tmodes);
+    }
+
+    if (job_is_completed(job))
+    {
+        finish_job(job); // Foreground jobs are forgotten silently
+    }
+    else
+    {
+        job->background = 1;
+        job->notified = 1;
+        printf("\n[%d] Stopped    %s\n", job->id, job->command);
+    }
+}
+
+void put_job_in_background(Job *job, int cont)
+{
+    job->background = 1;
+    if (cont)
+    {
+        for (int i = 0; i < job->num_procs; i++)
+        {
+            if (job->procs[i].state == PROC_STOPPED)
+            {
+                job->procs[i].state = PROC_RUNNING;
+            }
+        }
+        job->notified = 0;
+        if (kill(-job->pgid, SIGCONT) != 0)
+        {
+            perror("kill (SIGCONT)");
+        }
+    }
+}
+
+// Report finished and newly stopped background jobs, and free finished slots
+void do_job_notification()
+{
+    sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        Job *job = &jobs[i];
+        if (job->id == 0)
+        {
+            continue;
+        }
+        if (job_is_completed(job))
+        {
+            printf("[%d] Done       %s\n", job->id, job->command);
+            finish_job(job);
+        }
+        else if (job_is_stopped(job) && !job->notified)
+        {
+            printf("[%d] Stopped    %s\n", job->id, job->command);
+            job->notified = 1;
+        }
+    }
+    sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
+}
+
+void list_jobs()
+{
+    sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        Job *job = &jobs[i];
+        if (job->id == 0)
+        {
+            continue;
+        }
+        const char *state = job_is_completed(job) ? "Done"
+                          : job_is_stopped(job) ? "Stopped" : "Running";
+        printf("[%d] %-10s %s\n", job->id, state, job->command);
+    }
+    sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
+}
+
+static unsigned hash_name(const char *name)
+{
+    unsigned h = 2166136261u; // FNV-1a
+    for (; *name != '\0'; name++)
+    {
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    }
+    return h;
+}
+
+// Slot holding name, or the empty slot where it would go
+static HashEntry *hash_slot(const char *name)
+{
+    unsigned i = hash_name(name) & (HASH_SIZE - 1);
+    while (command_hash[i].name != NULL && strcmp(command_hash[i].name, name) != 0)
+    {
+        i = (i + 1) & (HASH_SIZE - 1);
+    }
+    return &command_hash[i];
+}
+
+void hash_clear()
+{
+    for (int i = 0; i < HASH_SIZE; i++)
+    {
+        free(command_hash[i].name);
+        free(command_hash[i].path);
+        command_hash[i].name = NULL;
+        command_hash[i].path = NULL;
+        command_hash[i].hits = 0;
+    }
+    command_hash_count = 0;
+}
+
+void hash_forget(const char *name)
+{
+    HashEntry *entry = hash_slot(name);
+    if (entry->name == NULL)
+    {
+        return;
+    }
+    free(entry->name);
+    free(entry->path);
+    entry->name = NULL;
+    entry->path = NULL;
+    command_hash_count--;
+
+    // Re-insert the rest of the probe run so later lookups do not stop early
+    unsigned i = (entry - command_hash + 1) & (HASH_SIZE - 1);
+    while (command_hash[i].name != NULL)
+    {
+        HashEntry moved = command_hash[i];
+        command_hash[i].name = NULL;
+        *hash_slot(moved.name) = moved;
+        i = (i + 1) & (HASH_SIZE - 1);
+    }
+}
+
+// Resolve a command to the executable that would be run, like execvp's PATH
+// search, but remember the answer. The cache is dropped whenever PATH changes.
+const char *lookup_command(const char *name)
+{
+    if (strchr(name, '/') != NULL)
+    {
+        return name; // Explicit paths are never searched or cached
+    }
+
+    const char *path_env = getenv("PATH");
+    if (path_env == NULL)
+    {
+        path_env = "/usr/local/bin:/usr/bin:/bin";
+    }
+    if (hashed_path_env == NULL || strcmp(hashed_path_env, path_env) != 0)
+    {
+        hash_clear();
+        free(hashed_path_env);
+        hashed_path_env = strdup(path_env);
+    }
+
+    HashEntry *entry = hash_slot(name);
+    if (entry->name != NULL)
+    {
+        entry->hits++;
+        return entry->path;
+    }
+
+    char candidate[4096];
+    const char *dir = path_env;
+    while (1)
+    {
+        const char *end = strchr(dir, ':');
+        size_t dir_len = end != NULL ? (size_t)(end - dir) : strlen(dir);
+        struct stat st;
+
+        // An empty PATH element means the current directory
+        int len = dir_len == 0 ? snprintf(candidate, sizeof(candidate), "./%s", name)
+                               : snprintf(candidate, sizeof(candidate), "%.*s/%s", (int)dir_len, dir, name);
+        if (len < (int)sizeof(candidate) && stat(candidate, &st) == 0 &&
+            S_ISREG(st.st_mode) && access(candidate, X_OK) == 0)
+        {
+            break;
+        }
+        if (end == NULL)
+        {
+            return NULL;
+        }
+        dir = end + 1;
+    }
+
+    if (command_hash_count >= HASH_SIZE / 2)
+    {
+        hash_clear(); // Keep the probe chains short
+        entry = hash_slot(name);
+    }
+    entry->name = strdup(name);
+    entry->path = strdup(candidate);
+    entry->hits = 1;
+    command_hash_count++;
+    return entry->path;
+}
+
+void hash_list()
+{
+    if (command_hash_count == 0)
+    {
+        printf("hash: hash table empty\n");
+        return;
+    }
+    printf("hits\tcommand\n");
+    for (int i = 0; i < HASH_SIZE; i++)
+    {
+        if (command_hash[i].name != NULL)
+        {
+            printf("%4u\t%s\n", command_hash[i].hits, command_hash[i].path);
+        }
+    }
+}
+
+// Read /proc/<pid>/stat for one process. Returns 0 on success.
+static int read_proc_stat(const char *pid_dir, char *comm, size_t comm_size, char *state,
+                          pid_t *ppid, pid_t *pgid, unsigned long long *cpu_ticks,
+                          unsigned long long *start_ticks, long *rss_pages)
+{
+    char path[sizeof("/proc//stat") + 256], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%s/stat", pid_dir);
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        return -1; // Process exited while we were scanning
+    }
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+    {
+        return -1;
+    }
+    buf[n] = '\0';
+
+    // comm is in parentheses and may itself contain spaces or ')'
+    char *open_paren = strchr(buf, '(');
+    char *close_paren = strrchr(buf, ')');
+    if (open_paren == NULL || close_paren == NULL || close_paren < open_paren)
+    {
+        return -1;
+    }
+    size_t len = close_paren - open_paren - 1;
+    if (len >= comm_size)
+    {
+        len = comm_size - 1;
+    }
+    memcpy(comm, open_paren + 1, len);
+    comm[len] = '\0';
+
+    // Fields after comm, numbered as in proc(5): 3 state, 4 ppid, 5 pgrp,
+    // 14 utime, 15 stime, 22 starttime, 24 rss
+    unsigned long long utime, stime;
+    int fields = sscanf(close_paren + 2,
+                        "%c %d %d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu "
+                        "%*d %*d %*d %*d %*d %*d %llu %*u %ld",
+                        state, ppid, pgid, &utime, &stime, start_ticks, rss_pages);
+    if (fields != 7)
+    {
+        return -1;
+    }
+    *cpu_ticks = utime + stime;
+    return 0;
+}
+
+// Built-in replacement for "/bin/ps | grep": scan /proc directly and list the
+// shell's process group and its jobs (every process with show_all).
+// Jobs run in their own process groups, so anything a job starts itself is
+// found by its group rather than its parent. The caller holds SIGCHLD blocked.
+static int is_job_pgid(pid_t pgid)
+{
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        if (jobs[i].id != 0 && jobs[i].pgid == pgid)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void list_processes(int show_all)
+{
+    static long clk_tck, page_kb;
+    if (clk_tck == 0)
+    {
+        clk_tck = sysconf(_SC_CLK_TCK);
+        page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    }
+
+    double uptime = 0;
+    int fd = open("/proc/uptime", O_RDONLY);
+    if (fd != -1)
+    {
+        char buf[64];
+        ssize_t n = read(fd, buf, sizeof(buf) - 1);
+        if (n > 0)
+        {
+            buf[n] = '\0';
+            uptime = atof(buf);
+        }
+        close(fd);
+    }
+
+    DIR *proc = opendir("/proc");
+    if (proc == NULL)
+    {
+        perror("ps: /proc");
+        return;
+    }
+
+    pid_t shell_pid = getpid();
+    sigprocmask(SIG_BLOCK, &sigchld_set, NULL); // Keep the job table still while we scan
+    printf("%7s %7s %7s %1s %5s %9s %8s %s\n", "PID", "PPID", "PGID", "S", "%CPU", "TIME", "RSS", "COMMAND");
+    struct dirent *entry;
+    while ((entry = readdir(proc)) != NULL)
+    {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9')
+        {
+            continue;
+        }
+
+        char comm[64], state;
+        pid_t ppid, pgid;
+        unsigned long long cpu_ticks, start_ticks;
+        long rss_pages;
+        if (read_proc_stat(entry->d_name, comm, sizeof(comm), &state, &ppid, &pgid,
+                           &cpu_ticks, &start_ticks, &rss_pages) != 0)
+        {
+            continue;
+        }
+        if (!show_all && pgid != shell_pgid && ppid != shell_pid && !is_job_pgid(pgid))
+        {
+            continue;
+        }
+
+        double cpu_seconds = (double)cpu_ticks / clk_tck;
+        double elapsed = uptime - (double)start_ticks / clk_tck;
+        double cpu_percent = elapsed > 0 ? 100.0 * cpu_seconds / elapsed : 0;
+        printf("%7s %7d %7d %c %5.1f %6lu:%02lu %8ld %s\n", entry->d_name, ppid, pgid, state,
+               cpu_percent, (unsigned long)cpu_seconds / 60, (unsigned long)cpu_seconds % 60,
+               rss_pages * page_kb, comm);
+    }
+    closedir(proc);
+    sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
+}
+
+static double now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Launch /bin/true with fork()+execvp() or posix_spawnp() until either
+// iterations launches (if positive) or max_us microseconds have passed.
+// Returns the mean microseconds per launch; SIGCHLD must be blocked.
+static double measure_launches(int use_fork, int iterations, double max_us, long *launches)
+{
+    extern char **environ;
+    char *argv[] = {"true", NULL};
+    double start = now_us(), elapsed = 0;
+    long n = 0;
+
+    while ((iterations <= 0 || n < iterations) && (max_us <= 0 || elapsed < max_us))
+    {
+        pid_t pid;
+        if (use_fork)
+        {
+            pid = fork();
+            if (pid == 0)
+            {
+                execvp(argv[0], argv);
+                _exit(127);
+            }
+            else if (pid < 0)
+            {
+                perror("fork");
+                break;
+            }
+        }
+        else
+        {
+            int err = posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ);
+            if (err != 0)
+            {
+                fprintf(stderr, "posix_spawnp: %s\n", strerror(err));
+                break;
+            }
+        }
+        waitpid(pid, NULL, 0);
+        n++;
+        elapsed = now_us() - start;
+    }
+    *launches = n;
+    return n > 0 ? elapsed / n : 0;
+}
+
+// Allocate and touch ballast_mb of heap so fork has page tables to copy
+static char *allocate_ballast(int ballast_mb)
+{
+    if (ballast_mb <= 0)
+    {
+        return NULL;
+    }
+    size_t size = (size_t)ballast_mb << 20;
+    char *ballast = malloc(size);
+    if (ballast == NULL)
+    {
+        perror("malloc");
+        return NULL;
+    }
+    memset(ballast, 1, size);
+    return ballast;
+}
+
+// Compare fork()+execvp() against posix_spawnp() launching /bin/true.
+// ballast_mb touches that much heap first to emulate a large parent process.
+void spawn_benchmark(int iterations, int ballast_mb)
+{
+    long launches;
+
+    if (iterations <= 0)
+    {
+        fprintf(stderr, "spawnbench: iterations must be positive\n");
+        return;
+    }
+    char *ballast = allocate_ballast(ballast_mb);
+
+    // Reap our own children here instead of letting sigchld_handler take them
+    sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+    double fork_us = measure_launches(1, iterations, 0, &launches);
+    double spawn_us = measure_launches(0, iterations, 0, &launches);
+    sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
+
+    printf("spawnbench: %d iterations, %d MB ballast\n", iterations, ballast_mb);
+    printf("  fork+execvp:  %.1f us/launch\n", fork_us);
+    printf("  posix_spawnp: %.1f us/launch\n", spawn_us);
+
+    free(ballast);
+}
+
+// Headless spawn-latency benchmark (--bench): fork vs posix_spawnp, with and
+// without a 256 MB parent, each for a quarter of the time; one JSON line out
+int spawn_benchmark_json(double seconds)
+{
+    long fork_n, spawn_n, fork_big_n, spawn_big_n;
+    double slice_us = seconds * 1e6 / 4;
+
+    sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+    double fork_us = measure_launches(1, 0, slice_us, &fork_n);
+    double spawn_us = measure_launches(0, 0, slice_us, &spawn_n);
+    char *ballast = allocate_ballast(256);
+    double fork_big_us = measure_launches(1, 0, slice_us, &fork_big_n);
+    double spawn_big_us = measure_launches(0, 0, slice_us, &spawn_big_n);
+    free(ballast);
+    sigprocmask(SIG_UNBLOCK, &sigchld_set, NULL);
+
+    printf("{\"program\": \"multitasking\", \"benchmark\": \"spawn_latency\", \"seconds\": %.3f, "
+           "\"fork_us\": %.1f, \"fork_launches\": %ld, \"spawn_us\": %.1f, \"spawn_launches\": %ld, "
+           "\"fork_256mb_us\": %.1f, \"fork_256mb_launches\": %ld, "
+           "\"spawn_256mb_us\": %.1f, \"spawn_256mb_launches\": %ld}\n",
+           seconds, fork_us, fork_n, spawn_us, spawn_n, fork_big_us, fork_big_n, spawn_big_us, spawn_big_n);
+    return 0;
+}
+
+void sigint_handler(int sig)
+{
+    printf("Received SIGINT.\n");
+}
+
+void sigterm_handler(int sig)
+{
+    printf("Received SIGTERM.\n");
+}
+
+// Reap every child that changed state and record it in the job table
+void sigchld_handler(int sig)
+{
+    int saved_errno = errno;
+    int status;
+    struct rusage usage;
+    pid_t pid;
+
+    while ((pid = wait4(-1, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0)
+    {
+        for (int i = 0; i < MAX_JOBS; i++)
+        {
+            if (jobs[i].id == 0)
+            {
+                continue;
+            }
+            for (int j = 0; j < jobs[i].num_procs; j++)
+            {
+                Process *proc = &jobs[i].procs[j];
+                if (proc->pid != pid)
+                {
+                    continue;
+                }
+                proc->status = status;
+                if (WIFSTOPPED(status))
+                {
+                    proc->state = PROC_STOPPED;
+                }
+                else if (WIFCONTINUED(status))
+                {
+                    proc->state = PROC_RUNNING;
+                }
+                else
+                {
+                    proc->state = PROC_DONE;
+                    proc->end_us = now_us(); // clock_gettime is async-signal-safe
+                    proc->usage = usage;
+                }
+            }
+        }
+    }
+    errno = saved_errno;
+}
+// Function to convert signal name to signal number
+int signame_to_signum(const char *signame)
+{
+    if (signame == NULL)
+    {
+        return -1;
+    }
+    if (strcmp(signame, "SIGINT") == 0)
+    {
+        return SIGINT; // Manual mapping for SIGINT
+    }
+    if (strcmp(signame, "SIGTERM") == 0)
+    {
+        return SIGTERM; // The default signal of kill
     }
 
     int signum = -1;
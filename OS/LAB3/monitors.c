@@ -3,10 +3,20 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include "../common/profiler.h"
+#include "../common/log.h"
+#include "../common/bench.h"
 
 #define MAX_READERS 12
 #define MAX_WRITERS 4
 #define MAX_ERASERS 2
+#define BENCH_LIST_LIMIT 64 // Longest list in benchmark mode
+
+int threads_alive = 0;
+int list_length = 0; // Changed only by writers and erasers, which exclude each other
+long reads_done, writes_done, erases_done;
 
 // Linked List Node
 typedef struct Node {
@@ -66,7 +76,10 @@ void exit_read(ListMonitor* monitor) {
     pthread_mutex_lock(&monitor->mutex);
     monitor->readers--;
     pthread_cond_signal(&monitor->can_write);
-    
+    if (monitor->readers == 0) {
+        pthread_cond_signal(&monitor->can_erase); // Erasers wait for the last reader
+    }
+
     pthread_mutex_unlock(&monitor->mutex);
 }
 
@@ -125,14 +138,21 @@ void append(LinkedList* list, int data) {
 }
 
 // Print the linked list
+// A long list is logged as several records, each within LOG_STR_BYTES
 void print_list(LinkedList* list) {
-    printf("List: ");
-    Node* current = list->head;
-    while (current != NULL) {
-        printf("%d ", current->data);
-        current = current->next;
+    if (LOG_LEVEL < LOG_LEVEL_INFO) {
+        return; // The records would be compiled out; skip the formatting too
+    }
+    char chunk[LOG_STR_BYTES];
+    int used = snprintf(chunk, sizeof(chunk), "List: ");
+    for (Node* current = list->head; current != NULL; current = current->next) {
+        if (used > (int)sizeof(chunk) - 16) { // No room left for another "%d "
+            LOG_INFO("%s", chunk);
+            used = 0;
+        }
+        used += snprintf(chunk + used, sizeof(chunk) - used, "%d ", current->data);
     }
-    printf("\n");
+    LOG_INFO("%s\n", chunk);
 }
 int choose_random_value(LinkedList* list) {
     if (list->head == NULL) {
@@ -198,24 +218,26 @@ int remove_random(LinkedList* list) {
 void* reader(void* arg) {
     ListMonitor* monitor = (ListMonitor*)arg;
     LinkedList* list = monitor->list; // Get shared list
-    while (1) {
+    while (running) {
         enter_read(monitor);
 
-        printf("Reader %lu starts using the list\n", pthread_self());
-        printf("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
+        LOG_INFO("Reader %lu starts using the list\n", pthread_self());
+        LOG_INFO("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
 
         // Simulate reading from the list
         int value = choose_random_value(list);
-        sleep(4);
+        pause_seconds(4);
 
-        printf("Reader %lu reads value %d from the list\n", pthread_self(), value);
-        printf("Reader %lu stops using the list\n", pthread_self());
-        printf("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
+        LOG_INFO("Reader %lu reads value %d from the list\n", pthread_self(), value);
+        LOG_INFO("Reader %lu stops using the list\n", pthread_self());
+        LOG_INFO("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
         print_list(list);
         exit_read(monitor);
+        __atomic_fetch_add(&reads_done, 1, __ATOMIC_RELAXED);
 
-        sleep(rand()%5 + 5);
+        pause_seconds(rand()%5 + 5);
     }
+    __atomic_fetch_sub(&threads_alive, 1, __ATOMIC_RELEASE);
     return NULL;
 }
 
@@ -223,25 +245,35 @@ void* reader(void* arg) {
 void* writer(void* arg) {
     ListMonitor* monitor = (ListMonitor*)arg;
     LinkedList* list = monitor->list; // Get shared list
-    while (1) {
+    while (running) {
         enter_write(monitor);
 
-        printf("Writer %lu starts using the list\n", pthread_self());
-        printf("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
+        LOG_INFO("Writer %lu starts using the list\n", pthread_self());
+        LOG_INFO("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
 
         // Simulate writing to the list
         int data = rand() % 100;
-        printf("Writer %lu adds %d to the end of the list\n", pthread_self(), data);
-        append(list, data);
+        LOG_INFO("Writer %lu adds %d to the end of the list\n", pthread_self(), data);
+        if (bench_mode && list_length >= BENCH_LIST_LIMIT && list->tail != NULL) {
+            // Readers hold off the erasers most of the time, so without a bound
+            // the list (and the O(n) read cost) would grow with the run length.
+            // Readers may be walking the list, so overwrite rather than free.
+            list->tail->data = data;
+        } else {
+            append(list, data);
+            __atomic_fetch_add(&list_length, 1, __ATOMIC_RELAXED);
+        }
         print_list(list);
 
-        printf("Writer %lu stops using the list\n", pthread_self());
-        printf("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
+        LOG_INFO("Writer %lu stops using the list\n", pthread_self());
+        LOG_INFO("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
 
         exit_write(monitor);
+        __atomic_fetch_add(&writes_done, 1, __ATOMIC_RELAXED);
 
-        sleep(rand()%5 + 5);
+        pause_seconds(rand()%5 + 5);
     }
+    __atomic_fetch_sub(&threads_alive, 1, __ATOMIC_RELEASE);
     return NULL;
 }
 
@@ -249,29 +281,44 @@ void* writer(void* arg) {
 void* eraser(void* arg) {
     ListMonitor* monitor = (ListMonitor*)arg;
     LinkedList* list = monitor->list; // Get shared list
-    while (1) {
+    while (running) {
         enter_erase(monitor);
 
-        printf("Eraser %lu starts using the list\n", pthread_self());
-        printf("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
+        LOG_INFO("Eraser %lu starts using the list\n", pthread_self());
+        LOG_INFO("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
         print_list(list);
 
         // Simulate erasing from the list
         int deleted = remove_random(list);
+        if (deleted != -1) {
+            __atomic_fetch_sub(&list_length, 1, __ATOMIC_RELAXED);
+        }
 
 
-        printf("Eraser %lu stops using the list, deleted: %d\n", pthread_self(), deleted);
-        printf("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
+        LOG_INFO("Eraser %lu stops using the list, deleted: %d\n", pthread_self(), deleted);
+        LOG_INFO("Active: readers=%d, writers=%d, erasers=%d\n", monitor->readers, monitor->writers, monitor->erasers);
         print_list(list);
         exit_erase(monitor);
+        __atomic_fetch_add(&erases_done, 1, __ATOMIC_RELAXED);
 
-        sleep(rand()%5 + 5);
+        pause_seconds(rand()%5 + 5);
     }
+    __atomic_fetch_sub(&threads_alive, 1, __ATOMIC_RELEASE);
     return NULL;
 }
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char *argv[]) {
+    profiler_start_from_env(); // LAB_PROFILE=out.folded to sample this run
+    double bench_seconds = 0;
+    unsigned seed = time(NULL);
+
+    // --bench SECONDS [SEED]: run the monitor flat out and report ops/sec as JSON
+    if (argc > 2 && strcmp(argv[1], "--bench") == 0) {
+        bench_mode = 1;
+        bench_seconds = atof(argv[2]);
+        seed = argc > 3 ? (unsigned)atoi(argv[3]) : 1;
+    }
+    srand(seed);
     LinkedList list;
     init_list(&list);
 
@@ -281,6 +328,7 @@ int main() {
     pthread_t readers[MAX_READERS];
     pthread_t writers[MAX_WRITERS];
     pthread_t erasers[MAX_ERASERS];
+    threads_alive = MAX_WRITERS + MAX_READERS + MAX_ERASERS;
 
     // Create writer threads
     for (int i = 0; i < MAX_WRITERS; i++) {
@@ -297,6 +345,22 @@ int main() {
         pthread_create(&erasers[i], NULL, eraser, (void*)&monitor);
     }
 
+    double elapsed = 0;
+    if (bench_mode) {
+        struct timespec poll = { 0, 1000000 };
+        elapsed = bench_run(bench_seconds);
+
+        // Threads parked in pthread_cond_wait need a nudge to see running == 0
+        while (__atomic_load_n(&threads_alive, __ATOMIC_ACQUIRE) > 0) {
+            pthread_mutex_lock(&monitor.mutex);
+            pthread_cond_broadcast(&monitor.can_read);
+            pthread_cond_broadcast(&monitor.can_write);
+            pthread_cond_broadcast(&monitor.can_erase);
+            pthread_mutex_unlock(&monitor.mutex);
+            nanosleep(&poll, NULL);
+        }
+    }
+
     // Wait for threads to finish
     for (int i = 0; i < MAX_WRITERS; i++) {
         pthread_join(writers[i], NULL);
@@ -308,5 +372,12 @@ int main() {
         pthread_join(erasers[i], NULL);
     }
 
+    if (bench_mode) {
+        long ops = reads_done + writes_done + erases_done;
+        printf("{\"program\": \"monitors\", \"benchmark\": \"monitor_ops\", \"seconds\": %.3f, \"seed\": %u, "
+               "\"reads\": %ld, \"writes\": %ld, \"erases\": %ld, \"ops_per_sec\": %.0f}\n",
+               elapsed, seed, reads_done, writes_done, erases_done, ops / elapsed);
+    }
+
     return 0;
 }
\ No newline at end of file
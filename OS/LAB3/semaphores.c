@@ -4,7 +4,12 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <semaphore.h>
+#include <sched.h>
 #include <ctype.h>
+#include <string.h>
+#include "../common/profiler.h"
+#include "../common/log.h"
+#include "../common/bench.h"
 
 #define NUM_INPUT_THREADS 8
 #define NUM_WORK_THREADS 6
@@ -22,56 +27,56 @@ typedef struct {
 CircularBuffer input_buffers[NUM_WORK_THREADS];
 CircularBuffer output_buffers[NUM_OUTPUT_THREADS];
 
-// Semaphores for input and output buffers
+// Semaphores for input and output buffers: free slots in each. Only waited
+// on in benchmark mode, where producers would otherwise overwrite data that
+// was never consumed and throughput would measure contention on Bsem.
 sem_t input_semaphores[NUM_WORK_THREADS];
 sem_t output_semaphores[NUM_OUTPUT_THREADS];
 
-void print_buffers() {
-    printf("INBUF[]: ");
-    for (int i = 0; i < NUM_WORK_THREADS; i++) {
-        for (int j = 0; j < BUFFER_SIZE; j++) {
-            if (input_buffers[i].buffer[j]) {
-                printf("%c", input_buffers[i].buffer[j]);
-            } else {
-                printf("-");
-            }
-        }
-        printf(" ");
-    }
-    printf("\n");
-    printf("OUTBUF[]: ");
-    for (int i = 0; i < NUM_OUTPUT_THREADS; i++) {
+long inputs_done, processed_done, outputs_done;
+
+// Render one row of buffers as "abc -b- ..." with '-' for empty slots
+static void format_buffers(char *out, CircularBuffer *buffers, int count) {
+    for (int i = 0; i < count; i++) {
         for (int j = 0; j < BUFFER_SIZE; j++) {
-            if (output_buffers[i].buffer[j]) {
-                printf("%c", output_buffers[i].buffer[j]);
-            } else {
-                printf("-");
-            }
+            *out++ = buffers[i].buffer[j] ? buffers[i].buffer[j] : '-';
         }
-        printf(" ");
+        *out++ = ' ';
     }
-    printf("\n");
+    *out = '\0';
+}
+
+void print_buffers() {
+    char in[NUM_WORK_THREADS * (BUFFER_SIZE + 1) + 1];
+    char out[NUM_OUTPUT_THREADS * (BUFFER_SIZE + 1) + 1];
+    format_buffers(in, input_buffers, NUM_WORK_THREADS);
+    format_buffers(out, output_buffers, NUM_OUTPUT_THREADS);
+    LOG_INFO("INBUF[]: %s\nOUTBUF[]: %s\n", in, out);
 }
 
 void *input_thread(void *arg) {
     int thread_id = *((int *)arg);
-    while (1) {
+    while (running) {
         char data = 'A' + rand() % 26; // Simulating input
         int index = rand() % NUM_WORK_THREADS;
+        if (bench_mode) {
+            sem_wait(&input_semaphores[index]); // Wait for a free slot
+        }
         sem_wait(&input_buffers[index].Bsem);
         input_buffers[index].buffer[input_buffers[index].input_index] = data;
         input_buffers[index].input_index = (input_buffers[index].input_index + 1) % BUFFER_SIZE;
         sem_post(&input_buffers[index].Bsem);
-        printf("U%d: get_input(%d)=>'%c'; process_input('%c')=>%d; '%c' => INBUF[%d]\n", thread_id, thread_id, data, data, index, data, index);
+        __atomic_fetch_add(&inputs_done, 1, __ATOMIC_RELAXED);
+        LOG_INFO("U%d: get_input(%d)=>'%c'; process_input('%c')=>%d; '%c' => INBUF[%d]\n", thread_id, thread_id, data, data, index, data, index);
         print_buffers(); // Print buffers after each input
-        sleep(rand() % MAX_SLEEP_SECONDS);
+        pause_seconds(rand() % MAX_SLEEP_SECONDS);
     }
     return NULL;
 }
 void *work_thread(void *arg) {
     int thread_id = *((int *)arg);
-    while (1) {
-        for (int i = 0; i < NUM_INPUT_THREADS; i++) {
+    while (running) {
+        for (int i = 0; i < NUM_INPUT_THREADS && running; i++) {
             // Choose an output buffer index randomly
             int output_index = rand() % NUM_OUTPUT_THREADS;
 
@@ -92,7 +97,7 @@ void *work_thread(void *arg) {
                 }
 
                 // Simulate processing
-                sleep(rand() % MAX_SLEEP_SECONDS);
+                pause_seconds(rand() % MAX_SLEEP_SECONDS);
 
                 // Update input buffer
                 input_buffers[input_buffer_index].buffer[input_buffers[input_buffer_index].output_index] = '\0';
@@ -100,6 +105,10 @@ void *work_thread(void *arg) {
 
                 // Release the semaphore for the input buffer
                 sem_post(&input_buffers[input_buffer_index].Bsem);
+                if (bench_mode) {
+                    sem_post(&input_semaphores[input_buffer_index]); // Slot freed
+                    sem_wait(&output_semaphores[output_index]);      // Wait for a free slot
+                }
 
                 // Wait on the semaphore for the chosen output buffer
                 sem_wait(&output_buffers[output_index].Bsem);
@@ -107,9 +116,10 @@ void *work_thread(void *arg) {
                 // Update the output buffer
                 output_buffers[output_index].buffer[output_buffers[output_index].input_index] = data;
                 output_buffers[output_index].input_index = (output_buffers[output_index].input_index + 1) % BUFFER_SIZE;
+                __atomic_fetch_add(&processed_done, 1, __ATOMIC_RELAXED);
 
                 // Print processing information
-                printf("R%d: taking from INBUF[%d] => '%c' and processing\n", thread_id, input_buffer_index, data);
+                LOG_INFO("R%d: taking from INBUF[%d] => '%c' and processing\n", thread_id, input_buffer_index, data);
                 print_buffers(); // Print buffers after each processing
 
                 // Release the semaphore for the output buffer
@@ -117,6 +127,9 @@ void *work_thread(void *arg) {
             } else {
                 // Release the semaphore for the input buffer
                 sem_post(&input_buffers[input_buffer_index].Bsem);
+                if (bench_mode) {
+                    sched_yield(); // Nothing to process; let the producers run
+                }
 
                 // Release the semaphore for the output buffer
                 //sem_post(&output_buffers[output_index].Bsem);
@@ -128,24 +141,42 @@ void *work_thread(void *arg) {
 
 void *output_thread(void *arg) {
     int thread_id = *((int *)arg);
-    while (1) {
+    while (running) {
         sem_wait(&output_buffers[thread_id].Bsem);
         char data = output_buffers[thread_id].buffer[output_buffers[thread_id].output_index];
         if (isalpha(data)) {
             output_buffers[thread_id].buffer[output_buffers[thread_id].output_index] = '\0';
             output_buffers[thread_id].output_index = (output_buffers[thread_id].output_index + 1) % BUFFER_SIZE;
             sem_post(&output_buffers[thread_id].Bsem);
-            printf("O%d: output from OUBUF[%d]=>'%c'printing %c\n", thread_id, thread_id, data, data);
+            if (bench_mode) {
+                sem_post(&output_semaphores[thread_id]); // Slot freed
+            }
+            __atomic_fetch_add(&outputs_done, 1, __ATOMIC_RELAXED);
+            LOG_INFO("O%d: output from OUBUF[%d]=>'%c'printing %c\n", thread_id, thread_id, data, data);
             print_buffers();
-            sleep(rand() % MAX_SLEEP_SECONDS);
+            pause_seconds(rand() % MAX_SLEEP_SECONDS);
         } else {
             sem_post(&output_buffers[thread_id].Bsem);
+            if (bench_mode) {
+                sched_yield(); // Nothing to print; let the producers run
+            }
         }
     }
     return NULL;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    profiler_start_from_env(); // LAB_PROFILE=out.folded to sample this run
+    double bench_seconds = 0;
+    unsigned seed = 1; // Same sequence as an unseeded rand()
+
+    // --bench SECONDS [SEED]: run the pipeline flat out and report throughput as JSON
+    if (argc > 2 && strcmp(argv[1], "--bench") == 0) {
+        bench_mode = 1;
+        bench_seconds = atof(argv[2]);
+        seed = argc > 3 ? (unsigned)atoi(argv[3]) : 1;
+    }
+    srand(seed);
     pthread_t input_threads[NUM_INPUT_THREADS];
     pthread_t work_threads[NUM_WORK_THREADS];
     pthread_t output_threads[NUM_OUTPUT_THREADS];
@@ -158,13 +189,13 @@ int main() {
         sem_init(&input_buffers[i].Bsem, 0, 1); // Initialize Bsem to 1
         input_buffers[i].input_index = 0;
         input_buffers[i].output_index = 0;
-        sem_init(&input_semaphores[i], 0, 1); // Initialize semaphore for input buffer
+        sem_init(&input_semaphores[i], 0, BUFFER_SIZE); // Initialize semaphore for input buffer
     }
     for (int i = 0; i < NUM_OUTPUT_THREADS; i++) {
         sem_init(&output_buffers[i].Bsem, 0, 1); // Initialize Bsem to 1
         output_buffers[i].input_index = 0;
         output_buffers[i].output_index = 0;
-        sem_init(&output_semaphores[i], 0, 1); // Initialize semaphore for output buffer
+        sem_init(&output_semaphores[i], 0, BUFFER_SIZE); // Initialize semaphore for output buffer
     }
 
     // Create input threads
@@ -172,13 +203,13 @@ int main() {
         input_thread_ids[i] = i;
         pthread_create(&input_threads[i], NULL, input_thread, &input_thread_ids[i]);
     }
-    sleep(4);
+    pause_seconds(4);
 
     // Create work threads
     for (int i = 0; i < NUM_WORK_THREADS; i++) {
         work_thread_ids[i] = i;
         pthread_create(&work_threads[i], NULL, work_thread, &work_thread_ids[i]);
-        sleep(1);
+        pause_seconds(1);
     }
 
     // Create output threads
@@ -187,6 +218,22 @@ int main() {
         pthread_create(&output_threads[i], NULL, output_thread, &output_thread_ids[i]);
     }
 
+    double elapsed = 0;
+    if (bench_mode) {
+        elapsed = bench_run(bench_seconds);
+
+        // Release producers parked waiting for a free slot; each thread makes
+        // at most one more wait before it sees running == 0
+        for (int i = 0; i < NUM_INPUT_THREADS + NUM_WORK_THREADS; i++) {
+            for (int j = 0; j < NUM_WORK_THREADS; j++) {
+                sem_post(&input_semaphores[j]);
+            }
+            for (int j = 0; j < NUM_OUTPUT_THREADS; j++) {
+                sem_post(&output_semaphores[j]);
+            }
+        }
+    }
+
     // Join threads
     for (int i = 0; i < NUM_INPUT_THREADS; i++) {
         pthread_join(input_threads[i], NULL);
@@ -198,6 +245,12 @@ int main() {
         pthread_join(output_threads[i], NULL);
     }
 
+    if (bench_mode) {
+        printf("{\"program\": \"semaphores\", \"benchmark\": \"pipeline_throughput\", \"seconds\": %.3f, "
+               "\"seed\": %u, \"inputs\": %ld, \"processed\": %ld, \"outputs\": %ld, \"outputs_per_sec\": %.0f}\n",
+               elapsed, seed, inputs_done, processed_done, outputs_done, outputs_done / elapsed);
+    }
+
     // Cleanup
     for (int i = 0; i < NUM_WORK_THREADS; i++) {
         sem_destroy(&input_buffers[i].Bsem);
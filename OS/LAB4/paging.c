@@ -1,5 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../common/log.h"
 
 #define PAGE_SIZE 64
 #define NUM_PAGES 256
@@ -25,6 +28,9 @@ typedef struct {
 typedef struct {
     PageTable page_table;
     Memory memory;
+    int frame_page[NUM_FRAMES]; // Page held by each frame, -1 if free
+    int next_victim;            // FIFO replacement pointer
+    long page_faults;
 } OnDemandPagingSimulator;
 
 void access_memory(OnDemandPagingSimulator *simulator, int logical_address) {
@@ -33,29 +39,64 @@ void access_memory(OnDemandPagingSimulator *simulator, int logical_address) {
 
     int frame_number = simulator->page_table.entries[page_number].frame_number;
     if (!simulator->page_table.entries[page_number].valid) {
-        printf("Page fault occurred for page: %d\n", page_number);
-        // Simulate loading page from disk
+        LOG_INFO("Page fault occurred for page: %d\n", page_number);
+        simulator->page_faults++;
+        // Take a free frame, or evict the oldest resident page (FIFO)
+        frame_number = -1;
         for (int i = 0; i < NUM_FRAMES; i++) {
-            if (!simulator->page_table.entries[i].valid) {
+            if (simulator->frame_page[i] == -1) {
                 frame_number = i;
-                simulator->page_table.entries[page_number].frame_number = i;
-                simulator->page_table.entries[page_number].valid = 1;
-                printf("Page table entry %d is invalid, loading page %d into frame %d\n", page_number, page_number, frame_number);
                 break;
             }
         }
+        if (frame_number == -1) {
+            frame_number = simulator->next_victim;
+            simulator->next_victim = (simulator->next_victim + 1) % NUM_FRAMES;
+            int victim = simulator->frame_page[frame_number];
+            simulator->page_table.entries[victim].valid = 0;
+            LOG_INFO("Evicting page %d from frame %d\n", victim, frame_number);
+        }
+        // Simulate loading page from disk
+        simulator->frame_page[frame_number] = page_number;
+        simulator->page_table.entries[page_number].frame_number = frame_number;
+        simulator->page_table.entries[page_number].valid = 1;
+        LOG_INFO("Page table entry %d is invalid, loading page %d into frame %d\n", page_number, page_number, frame_number);
     }
 
     int physical_address = frame_number * PAGE_SIZE + offset;
-    printf("Accessing logical address: %d\n", logical_address);
-    printf("Page number: %d\n", page_number);
-    printf("Frame number: %d\n", frame_number);
-    printf("Offset: %d\n", offset);
-    printf("Physical address: %d\n", physical_address);
-    printf("Content of memory at physical address: %s\n", simulator->memory.frames[frame_number].data);
+    LOG_INFO("Accessing logical address: %d\n", logical_address);
+    LOG_INFO("Page number: %d\n", page_number);
+    LOG_INFO("Frame number: %d\n", frame_number);
+    LOG_INFO("Offset: %d\n", offset);
+    LOG_INFO("Physical address: %d\n", physical_address);
+    LOG_INFO("Content of memory at physical address: %s\n", simulator->memory.frames[frame_number].data);
 }
 
-int main() {
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Headless benchmark: uniformly random accesses for the given time, one JSON line out
+void run_benchmark(OnDemandPagingSimulator *simulator, double seconds, unsigned seed) {
+    long accesses = 0;
+    double start = now_seconds(), elapsed = 0;
+
+    srand(seed);
+    while (elapsed < seconds) {
+        for (int i = 0; i < 4096; i++) {
+            access_memory(simulator, rand() % (NUM_PAGES * PAGE_SIZE));
+        }
+        accesses += 4096;
+        elapsed = now_seconds() - start;
+    }
+    printf("{\"program\": \"paging\", \"benchmark\": \"paging_accesses\", \"seconds\": %.3f, \"seed\": %u, "
+           "\"accesses\": %ld, \"page_faults\": %ld, \"accesses_per_sec\": %.0f}\n",
+           elapsed, seed, accesses, simulator->page_faults, accesses / elapsed);
+}
+
+int main(int argc, char *argv[]) {
     OnDemandPagingSimulator simulator;
     
     // Initialize page table entries as invalid
@@ -63,6 +104,18 @@ int main() {
         simulator.page_table.entries[i].frame_number = -1;
         simulator.page_table.entries[i].valid = 0;
     }
+    memset(&simulator.memory, 0, sizeof(simulator.memory));
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        simulator.frame_page[i] = -1;
+    }
+    simulator.next_victim = 0;
+    simulator.page_faults = 0;
+
+    // --bench SECONDS [SEED]
+    if (argc > 2 && strcmp(argv[1], "--bench") == 0) {
+        run_benchmark(&simulator, atof(argv[2]), argc > 3 ? (unsigned)atoi(argv[3]) : 1);
+        return 0;
+    }
 
     // Access some memory addresses
     access_memory(&simulator, 0);
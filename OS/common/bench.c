@@ -0,0 +1,26 @@
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+int bench_mode = 0;
+volatile int running = 1;
+
+void pause_seconds(int seconds)
+{
+    if (!bench_mode) {
+        sleep(seconds);
+    }
+}
+
+double bench_run(double seconds)
+{
+    struct timespec duration = { (time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9) };
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    nanosleep(&duration, NULL);
+    running = 0;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
@@ -0,0 +1,23 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+ * Headless benchmark support shared by the lab programs (--bench).
+ *
+ * In benchmark mode pause_seconds() returns at once so the threads run flat
+ * out, and bench_run() ends the run by clearing running, which every thread
+ * loop checks.
+ */
+
+extern int bench_mode;
+extern volatile int running;
+
+// sleep() that is skipped in benchmark mode
+void pause_seconds(int seconds);
+
+// Let the threads run for the given time, then clear running. Returns the
+// measured run time, taken before any thread is joined so that shutdown is
+// not counted.
+double bench_run(double seconds);
+
+#endif
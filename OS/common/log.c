@@ -0,0 +1,405 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "log.h"
+
+#define LOG_RING_SIZE 512 // Records per thread (power of two)
+#define LOG_FLUSH_NS 5000000L // Flusher polls every 5 ms
+#define LOG_OUT_BYTES 65536 // Formatted output is written in chunks this size
+
+typedef union {
+    long long i;
+    unsigned long long u;
+    double d;
+    void *p;
+} LogArg;
+
+typedef struct {
+    const char *fmt;
+    long long ts_ns;
+    int nargs;
+    LogArg args[LOG_MAX_ARGS];
+    char strings[LOG_STR_BYTES];
+} LogRecord;
+
+// Single producer (the owning thread) and single consumer (the flusher)
+typedef struct LogRing {
+    unsigned long head;    // Next slot the producer writes
+    unsigned long tail;    // Next slot the flusher reads
+    unsigned long dropped; // Records lost because the ring was full
+    unsigned long dropped_reported;
+    int retired;           // Owning thread has exited; freed once drained
+    struct LogRing *next;
+    LogRecord records[LOG_RING_SIZE];
+} LogRing;
+
+// One conversion specification of a printf format
+typedef struct {
+    const char *start; // The '%'
+    const char *end;   // Just past the conversion character
+    const char *length; // Start of the length modifier
+    int length_chars;
+    char conv;
+} LogSpec;
+
+static LogRing *rings; // Rings of live threads and undrained retired ones, newest first
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread LogRing *my_ring;
+static pthread_key_t ring_key; // Retires a thread's ring when it exits
+static pthread_once_t flusher_once = PTHREAD_ONCE_INIT;
+static pthread_t flusher;
+static int flusher_running;
+static long long drained_ns; // Every record logged before this has been written
+
+static long long log_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Find the next conversion at or after p; returns 0 at the end of the format
+static int next_spec(const char *p, LogSpec *spec)
+{
+    while ((p = strchr(p, '%')) != NULL) {
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        spec->start = p++;
+        p += strspn(p, "-+ #0'");
+        p += strspn(p, "0123456789");
+        if (*p == '.') {
+            p++;
+            p += strspn(p, "0123456789");
+        }
+        spec->length = p;
+        spec->length_chars = strspn(p, "hlLqjzt");
+        p += spec->length_chars;
+        spec->conv = *p;
+        spec->end = *p != '\0' ? p + 1 : p;
+        return 1;
+    }
+    return 0;
+}
+
+static int spec_has_length(const LogSpec *spec, const char *mod)
+{
+    return spec->length_chars == (int)strlen(mod) && strncmp(spec->length, mod, spec->length_chars) == 0;
+}
+
+static void *flusher_thread(void *arg);
+
+// Runs as the owning thread exits; the flusher frees the ring once it is empty
+static void log_retire_ring(void *arg)
+{
+    LogRing *ring = arg;
+    my_ring = NULL;
+    __atomic_store_n(&ring->retired, 1, __ATOMIC_RELEASE);
+}
+
+static void log_start()
+{
+    pthread_key_create(&ring_key, log_retire_ring);
+    flusher_running = 1;
+    pthread_create(&flusher, NULL, flusher_thread, NULL);
+    atexit(log_shutdown);
+}
+
+static LogRing *log_register_thread()
+{
+    pthread_once(&flusher_once, log_start);
+    // Mapped rather than malloc'd so a retired ring's pages go back to the system
+    LogRing *ring = mmap(NULL, sizeof(LogRing), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        return NULL;
+    }
+    pthread_mutex_lock(&rings_lock);
+    ring->next = rings;
+    __atomic_store_n(&rings, ring, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&rings_lock);
+    pthread_setspecific(ring_key, ring);
+    return ring;
+}
+
+void log_write(int level, const char *fmt, ...)
+{
+    (void)level; // Filtering already happened at compile time in LOG_AT
+    if (my_ring == NULL && (my_ring = log_register_thread()) == NULL) {
+        return;
+    }
+
+    LogRing *ring = my_ring;
+    unsigned long head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == LOG_RING_SIZE) {
+        ring->dropped++;
+        return;
+    }
+
+    LogRecord *rec = &ring->records[head & (LOG_RING_SIZE - 1)];
+    rec->fmt = fmt;
+    rec->ts_ns = log_now_ns();
+    rec->nargs = 0;
+
+    // Pull each argument with the type its conversion implies
+    va_list ap;
+    va_start(ap, fmt);
+    size_t str_used = 0;
+    LogSpec spec;
+    const char *p = fmt;
+    while (rec->nargs < LOG_MAX_ARGS && next_spec(p, &spec)) {
+        LogArg *arg = &rec->args[rec->nargs++];
+        p = spec.end;
+        switch (spec.conv) {
+        case 'd': case 'i':
+            arg->i = spec_has_length(&spec, "ll") ? va_arg(ap, long long)
+                   : spec_has_length(&spec, "l") ? va_arg(ap, long)
+                   : spec_has_length(&spec, "z") ? va_arg(ap, ssize_t)
+                   : va_arg(ap, int);
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            arg->u = spec_has_length(&spec, "ll") ? va_arg(ap, unsigned long long)
+                   : spec_has_length(&spec, "l") ? va_arg(ap, unsigned long)
+                   : spec_has_length(&spec, "z") ? va_arg(ap, size_t)
+                   : va_arg(ap, unsigned int);
+            break;
+        case 'c':
+            arg->i = va_arg(ap, int);
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            arg->d = va_arg(ap, double);
+            break;
+        case 's': {
+            // Copy the string so the caller's buffer can go away; store its offset
+            const char *s = va_arg(ap, const char *);
+            if (s == NULL) {
+                s = "(null)";
+            }
+            size_t len = strlen(s);
+            if (len > LOG_STR_BYTES - 1 - str_used) {
+                len = LOG_STR_BYTES - 1 - str_used; // Truncate; later strings come out empty
+            }
+            memcpy(rec->strings + str_used, s, len);
+            rec->strings[str_used + len] = '\0';
+            arg->u = str_used;
+            str_used += len + 1;
+            if (str_used > LOG_STR_BYTES - 1) {
+                str_used = LOG_STR_BYTES - 1;
+            }
+            break;
+        }
+        default:
+            arg->p = va_arg(ap, void *); // %p, and anything unexpected
+            break;
+        }
+    }
+    va_end(ap);
+#ifndef NDEBUG
+    // The rest of the format would be printed with its conversions unfilled
+    if (next_spec(p, &spec)) {
+        fprintf(stderr, "log_write: more than %d conversions in \"%s\"\n", LOG_MAX_ARGS, fmt);
+        abort();
+    }
+#endif
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Copy literal format text from p up to end, turning "%%" into "%"
+static size_t copy_literal(char *out, size_t room, const char *p, const char *end)
+{
+    size_t used = 0;
+    while (p < end && used < room) {
+        out[used++] = *p;
+        p += (p[0] == '%' && p[1] == '%') ? 2 : 1;
+    }
+    return used;
+}
+
+// Format one record the way printf would have
+static size_t format_record(const LogRecord *rec, char *out, size_t size)
+{
+    size_t used = 0;
+    const char *p = rec->fmt;
+    LogSpec spec;
+    int arg_index = 0;
+
+    while (used < size - 1 && arg_index < rec->nargs && next_spec(p, &spec)) {
+        const LogArg *arg = &rec->args[arg_index++];
+        char conv_fmt[32];
+        int n;
+
+        used += copy_literal(out + used, size - 1 - used, p, spec.start);
+
+        // Rebuild the conversion with a length modifier matching the stored type
+        int prefix = (int)(spec.length - spec.start);
+        switch (spec.conv) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+            snprintf(conv_fmt, sizeof(conv_fmt), "%.*sll%c", prefix, spec.start, spec.conv);
+            n = snprintf(out + used, size - used, conv_fmt, arg->i);
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            snprintf(conv_fmt, sizeof(conv_fmt), "%.*s%c", prefix, spec.start, spec.conv);
+            n = snprintf(out + used, size - used, conv_fmt, arg->d);
+            break;
+        case 'c':
+            snprintf(conv_fmt, sizeof(conv_fmt), "%.*s%c", prefix, spec.start, spec.conv);
+            n = snprintf(out + used, size - used, conv_fmt, (int)arg->i);
+            break;
+        case 's':
+            snprintf(conv_fmt, sizeof(conv_fmt), "%.*s%c", prefix, spec.start, spec.conv);
+            n = snprintf(out + used, size - used, conv_fmt, rec->strings + arg->u);
+            break;
+        default:
+            n = snprintf(out + used, size - used, "%p", arg->p);
+            break;
+        }
+        used += n > 0 ? (size_t)n : 0;
+        p = spec.end;
+    }
+
+    if (used < size - 1) {
+        used += copy_literal(out + used, size - 1 - used, p, p + strlen(p));
+    }
+    if (used > size - 1) {
+        used = size - 1;
+    }
+    out[used] = '\0';
+    return used;
+}
+
+// Write out everything currently queued, oldest record first across threads.
+// A record that does not end its line is followed by the same thread's next
+// record, so a line logged in pieces is not split by other threads' output;
+// the rest of such a line is waited for for up to two flush periods. Records
+// logged after the pass started are left for the next one, so a steady stream
+// cannot keep the flusher from retiring rings.
+static void drain_rings()
+{
+    static char out[LOG_OUT_BYTES];
+    static LogRing *continuing; // Ring whose last record left its line open
+    static long long continuing_ns;
+    long long pass_ns = log_now_ns();
+    size_t used = 0;
+
+    while (1) {
+        LogRing *oldest = NULL;
+        LogRecord *oldest_rec = NULL;
+        if (continuing != NULL && continuing->tail == __atomic_load_n(&continuing->head, __ATOMIC_ACQUIRE)) {
+            if (__atomic_load_n(&flusher_running, __ATOMIC_ACQUIRE) &&
+                log_now_ns() - continuing_ns < 2 * LOG_FLUSH_NS) {
+                pass_ns = 0; // Leave everything else queued until the line is finished
+                break;
+            }
+            continuing = NULL;
+        }
+        for (LogRing *ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+            if (ring->tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+                continue;
+            }
+            if (ring == continuing) {
+                oldest = ring;
+                oldest_rec = &ring->records[ring->tail & (LOG_RING_SIZE - 1)];
+                break;
+            }
+            LogRecord *rec = &ring->records[ring->tail & (LOG_RING_SIZE - 1)];
+            if (oldest_rec == NULL || rec->ts_ns < oldest_rec->ts_ns) {
+                oldest = ring;
+                oldest_rec = rec;
+            }
+        }
+        if (oldest == NULL || oldest_rec->ts_ns > pass_ns) {
+            break;
+        }
+
+        if (LOG_OUT_BYTES - used < 1024) {
+            fwrite(out, 1, used, stdout);
+            used = 0;
+        }
+        size_t len = format_record(oldest_rec, out + used, LOG_OUT_BYTES - used);
+        used += len;
+        if (len > 0 && out[used - 1] != '\n') {
+            continuing = oldest;
+            continuing_ns = log_now_ns();
+        } else {
+            continuing = NULL;
+        }
+        __atomic_store_n(&oldest->tail, oldest->tail + 1, __ATOMIC_RELEASE);
+    }
+
+    for (LogRing *ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        unsigned long dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+        if (dropped != ring->dropped_reported) {
+            used += snprintf(out + used, LOG_OUT_BYTES - used, "[log] %lu records dropped\n",
+                             dropped - ring->dropped_reported);
+            ring->dropped_reported = dropped;
+            if (used >= LOG_OUT_BYTES - 64) {
+                fwrite(out, 1, used, stdout);
+                used = 0;
+            }
+        }
+    }
+
+    if (used > 0) {
+        fwrite(out, 1, used, stdout);
+        fflush(stdout);
+    }
+
+    if (pass_ns != 0) {
+        __atomic_store_n(&drained_ns, pass_ns, __ATOMIC_RELEASE);
+    }
+
+    // Free the rings of exited threads; only this thread ever unlinks
+    pthread_mutex_lock(&rings_lock);
+    LogRing **link = &rings;
+    while (*link != NULL) {
+        LogRing *ring = *link;
+        if (__atomic_load_n(&ring->retired, __ATOMIC_ACQUIRE) && ring != continuing &&
+            ring->tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) &&
+            ring->dropped == ring->dropped_reported) {
+            __atomic_store_n(link, ring->next, __ATOMIC_RELEASE);
+            munmap(ring, sizeof(LogRing));
+        } else {
+            link = &ring->next;
+        }
+    }
+    pthread_mutex_unlock(&rings_lock);
+}
+
+static void *flusher_thread(void *arg)
+{
+    (void)arg;
+    struct timespec period = { 0, LOG_FLUSH_NS };
+    while (__atomic_load_n(&flusher_running, __ATOMIC_ACQUIRE)) {
+        drain_rings();
+        nanosleep(&period, NULL);
+    }
+    drain_rings();
+    return NULL;
+}
+
+void log_flush()
+{
+    // Wait for a flusher pass that started after this call; rings may be freed
+    // meanwhile, so they are not walked here
+    struct timespec pause = { 0, 1000000 };
+    long long now = log_now_ns();
+    while (__atomic_load_n(&drained_ns, __ATOMIC_ACQUIRE) < now &&
+           __atomic_load_n(&flusher_running, __ATOMIC_ACQUIRE)) {
+        nanosleep(&pause, NULL);
+    }
+}
+
+void log_shutdown()
+{
+    if (__atomic_exchange_n(&flusher_running, 0, __ATOMIC_ACQ_REL)) {
+        pthread_join(flusher, NULL);
+    }
+}
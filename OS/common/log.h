@@ -0,0 +1,56 @@
+#ifndef LOG_H
+#define LOG_H
+
+/*
+ * Asynchronous logging shared by the lab programs.
+ *
+ * log_write() copies its arguments into a binary record in a ring owned by
+ * the calling thread; no lock is taken and nothing is formatted. A background
+ * flusher thread drains every ring, formats the records in timestamp order
+ * and writes them to stdout in large chunks.
+ *
+ * The format must be a string literal: only its pointer is stored. %s
+ * arguments are copied into the record (up to LOG_STR_BYTES in total), so
+ * callers may pass stack buffers. At most LOG_MAX_ARGS conversions are
+ * stored per record (debug builds abort on more) and '*' widths are not
+ * supported. Longer lines can be logged in pieces: a record that does not
+ * end in a newline is written together with the same thread's following
+ * records.
+ *
+ * Levels above LOG_LEVEL are compiled out entirely, e.g. build with
+ * -DLOG_LEVEL=LOG_LEVEL_WARN to drop the per-operation INFO traces.
+ */
+
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+#define LOG_MAX_ARGS 8 // Conversions stored per record
+#define LOG_STR_BYTES 256 // Room in one record for copies of its %s arguments
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_AT(level, ...) \
+    do { \
+        if ((level) <= LOG_LEVEL) \
+            log_write((level), __VA_ARGS__); \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// Queue one record; starts the flusher thread on first use.
+void log_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Block until everything logged so far has been written.
+void log_flush();
+
+// Stop the flusher after writing all pending records (also run at exit).
+void log_shutdown();
+
+#endif
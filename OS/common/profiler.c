@@ -0,0 +1,393 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include "profiler.h"
+
+#define PROFILER_MAX_THREADS 64
+#define PROFILER_RING_SIZE 4096 // Samples per thread between drains (power of two)
+#define PROFILER_DRAIN_NS 50000000L // The drain thread empties the rings every 50 ms
+#define PROFILER_MAX_DEPTH 32
+#define PROFILER_SKIP_FRAMES 2  // The handler itself and the signal trampoline
+
+typedef struct {
+    int depth;
+    void *frames[PROFILER_MAX_DEPTH];
+} Sample;
+
+// Single producer (the owning thread's SIGPROF handler) and single consumer
+// (the drain thread)
+typedef struct {
+    unsigned long head;    // Next slot the handler writes (release-published)
+    unsigned long tail;    // Next slot the drain thread reads
+    unsigned long dropped; // Samples lost because the ring was full
+    Sample samples[PROFILER_RING_SIZE];
+} SampleRing;
+
+// A distinct raw stack and how many samples hit it
+typedef struct {
+    Sample sample;
+    unsigned long count; // 0 marks an empty slot
+} StackCount;
+
+static SampleRing *rings;  // PROFILER_MAX_THREADS rings, mmap'ed so untouched ones cost nothing
+static int rings_claimed;
+static unsigned long rings_exhausted; // Samples from threads that found no free ring
+static __thread SampleRing *my_ring;
+static const char *exit_path;
+
+// Samples are folded into this table as they are drained, so memory grows
+// with the number of distinct stacks rather than with the length of the run.
+// Only the drain thread touches it until sampling stops.
+static StackCount *stack_counts;
+static size_t stack_counts_size, stack_counts_used;
+static unsigned long samples_total, samples_lost;
+static pthread_t drain_thread;
+static int draining;
+
+static void profiler_handler(int sig)
+{
+    void *frames[PROFILER_MAX_DEPTH + PROFILER_SKIP_FRAMES];
+
+    if (my_ring == NULL) {
+        // First sample in this thread: claim a ring without taking any lock
+        int index = __atomic_fetch_add(&rings_claimed, 1, __ATOMIC_RELAXED);
+        if (index >= PROFILER_MAX_THREADS) {
+            __atomic_fetch_add(&rings_exhausted, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        my_ring = &rings[index];
+    }
+
+    unsigned long head = my_ring->head;
+    if (head - __atomic_load_n(&my_ring->tail, __ATOMIC_ACQUIRE) == PROFILER_RING_SIZE) {
+        my_ring->dropped++;
+        return;
+    }
+
+    int depth = backtrace(frames, PROFILER_MAX_DEPTH + PROFILER_SKIP_FRAMES) - PROFILER_SKIP_FRAMES;
+    Sample *sample = &my_ring->samples[head & (PROFILER_RING_SIZE - 1)];
+    sample->depth = depth > 0 ? depth : 0;
+    memcpy(sample->frames, frames + PROFILER_SKIP_FRAMES, sample->depth * sizeof(void *));
+    __atomic_store_n(&my_ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static unsigned long hash_sample(const Sample *sample)
+{
+    unsigned long h = 14695981039346656037ul; // FNV-1a over the frame addresses
+    for (int f = 0; f < sample->depth; f++) {
+        h = (h ^ (unsigned long)sample->frames[f]) * 1099511628211ul;
+    }
+    return h;
+}
+
+static StackCount *stack_slot(StackCount *table, size_t size, const Sample *sample)
+{
+    size_t i = hash_sample(sample) & (size - 1);
+    while (table[i].count != 0 &&
+           (table[i].sample.depth != sample->depth ||
+            memcmp(table[i].sample.frames, sample->frames, sample->depth * sizeof(void *)) != 0)) {
+        i = (i + 1) & (size - 1);
+    }
+    return &table[i];
+}
+
+// Add one sample to stack_counts, doubling the table at half load
+static void count_sample(const Sample *sample)
+{
+    if (2 * (stack_counts_used + 1) > stack_counts_size) {
+        size_t size = stack_counts_size != 0 ? 2 * stack_counts_size : 1024;
+        StackCount *table = calloc(size, sizeof(StackCount));
+        if (table == NULL) {
+            samples_lost++;
+            return;
+        }
+        for (size_t i = 0; i < stack_counts_size; i++) {
+            if (stack_counts[i].count != 0) {
+                *stack_slot(table, size, &stack_counts[i].sample) = stack_counts[i];
+            }
+        }
+        free(stack_counts);
+        stack_counts = table;
+        stack_counts_size = size;
+    }
+
+    StackCount *slot = stack_slot(stack_counts, stack_counts_size, sample);
+    if (slot->count == 0) {
+        slot->sample = *sample;
+        stack_counts_used++;
+    }
+    slot->count++;
+    samples_total++;
+}
+
+static void drain_rings()
+{
+    int num_rings = __atomic_load_n(&rings_claimed, __ATOMIC_RELAXED);
+    if (num_rings > PROFILER_MAX_THREADS) {
+        num_rings = PROFILER_MAX_THREADS;
+    }
+    for (int r = 0; r < num_rings; r++) {
+        SampleRing *ring = &rings[r];
+        unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        for (unsigned long t = ring->tail; t != head; t++) {
+            count_sample(&ring->samples[t & (PROFILER_RING_SIZE - 1)]);
+        }
+        __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+    }
+}
+
+static void *drain_thread_main(void *arg)
+{
+    (void)arg;
+    struct timespec period = { 0, PROFILER_DRAIN_NS };
+
+    // Keep the profiler's own bookkeeping out of the profile, and leave
+    // every other signal to the program's threads
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, NULL);
+
+    while (__atomic_load_n(&draining, __ATOMIC_ACQUIRE)) {
+        drain_rings();
+        nanosleep(&period, NULL);
+    }
+    return NULL;
+}
+
+int profiler_start(int hz)
+{
+    if (hz <= 0) {
+        return -1;
+    }
+    rings = mmap(NULL, PROFILER_MAX_THREADS * sizeof(SampleRing), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (rings == MAP_FAILED) {
+        rings = NULL;
+        perror("profiler: mmap");
+        return -1;
+    }
+
+    // backtrace() loads libgcc on first use, which is not safe inside a handler
+    void *warmup[1];
+    backtrace(warmup, 1);
+
+    draining = 1;
+    if (pthread_create(&drain_thread, NULL, drain_thread_main, NULL) != 0) {
+        perror("profiler: pthread_create");
+        munmap(rings, PROFILER_MAX_THREADS * sizeof(SampleRing));
+        rings = NULL;
+        return -1;
+    }
+
+    struct sigaction act;
+    act.sa_handler = profiler_handler;
+    sigemptyset(&act.sa_mask);
+    act.sa_flags = SA_RESTART;
+    sigaction(SIGPROF, &act, NULL);
+
+    // setitimer rejects tv_usec >= 1000000, so 1 Hz must be expressed in seconds
+    long usec = hz > 1000000 ? 1 : 1000000 / hz;
+    struct itimerval timer;
+    timer.it_interval.tv_sec = usec / 1000000;
+    timer.it_interval.tv_usec = usec % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+        perror("profiler: setitimer");
+        act.sa_handler = SIG_DFL;
+        sigaction(SIGPROF, &act, NULL);
+        __atomic_store_n(&draining, 0, __ATOMIC_RELEASE);
+        pthread_join(drain_thread, NULL);
+        munmap(rings, PROFILER_MAX_THREADS * sizeof(SampleRing));
+        rings = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Symbolized frames are cached by address so each one is resolved only once
+typedef struct {
+    void *addr;
+    char *name;
+} SymbolEntry;
+
+static SymbolEntry *symbols;
+static size_t symbols_size;
+
+static const char *symbol_name(void *addr)
+{
+    size_t i = ((unsigned long)addr >> 4) & (symbols_size - 1);
+    while (symbols[i].addr != NULL && symbols[i].addr != addr) {
+        i = (i + 1) & (symbols_size - 1);
+    }
+    if (symbols[i].addr != NULL) {
+        return symbols[i].name;
+    }
+
+    // Name the frame by its function, or by module+offset when the symbol is
+    // not exported; offsets from the load address stay the same under ASLR
+    Dl_info info;
+    char name[256];
+    int found = dladdr(addr, &info) != 0;
+    if (found && info.dli_sname != NULL) {
+        snprintf(name, sizeof(name), "%s", info.dli_sname);
+    } else if (found && info.dli_fname != NULL) {
+        const char *slash = strrchr(info.dli_fname, '/');
+        snprintf(name, sizeof(name), "%s+0x%lx", slash != NULL ? slash + 1 : info.dli_fname,
+                 (unsigned long)((char *)addr - (char *)info.dli_fbase));
+    } else {
+        snprintf(name, sizeof(name), "%p", addr);
+    }
+
+    symbols[i].addr = addr;
+    symbols[i].name = strdup(name);
+    return symbols[i].name;
+}
+
+typedef struct {
+    char *text;
+    unsigned long count;
+} StackLine;
+
+static int compare_lines(const void *a, const void *b)
+{
+    return strcmp(((const StackLine *)a)->text, ((const StackLine *)b)->text);
+}
+
+void profiler_stop(const char *path)
+{
+    if (rings == NULL) {
+        return;
+    }
+
+    struct itimerval off = { { 0, 0 }, { 0, 0 } };
+    setitimer(ITIMER_PROF, &off, NULL);
+    signal(SIGPROF, SIG_IGN);
+
+    __atomic_store_n(&draining, 0, __ATOMIC_RELEASE);
+    pthread_join(drain_thread, NULL);
+    drain_rings();
+
+    int num_rings = rings_claimed < PROFILER_MAX_THREADS ? rings_claimed : PROFILER_MAX_THREADS;
+    unsigned long total = samples_total, dropped = rings_exhausted + samples_lost, frames = 0;
+    for (int r = 0; r < num_rings; r++) {
+        dropped += rings[r].dropped;
+    }
+    for (size_t i = 0; i < stack_counts_size; i++) {
+        frames += stack_counts[i].sample.depth;
+    }
+
+    // Render every distinct stack as a root-first ";"-joined line, then sort
+    // so lines that symbolize identically are adjacent and can be merged.
+    // There can be at most one distinct address per stored frame, so at twice
+    // that the symbol table never fills and its probes always end.
+    symbols_size = 1;
+    while (symbols_size < 2 * frames + 64) {
+        symbols_size <<= 1;
+    }
+    symbols = calloc(symbols_size, sizeof(SymbolEntry));
+    StackLine *stacks = malloc((stack_counts_used + 1) * sizeof(StackLine));
+    size_t n = 0;
+    for (size_t i = 0; i < stack_counts_size; i++) {
+        Sample *sample = &stack_counts[i].sample;
+        if (stack_counts[i].count == 0) {
+            continue;
+        }
+        char line[PROFILER_MAX_DEPTH * 64];
+        size_t len = 0;
+        line[0] = '\0';
+        for (int f = sample->depth - 1; f >= 0 && len < sizeof(line) - 1; f--) {
+            len += snprintf(line + len, sizeof(line) - len, "%s%s",
+                            len > 0 ? ";" : "", symbol_name(sample->frames[f]));
+        }
+        stacks[n].text = strdup(line);
+        stacks[n++].count = stack_counts[i].count;
+    }
+    qsort(stacks, n, sizeof(StackLine), compare_lines);
+
+    FILE *out = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (out == NULL) {
+        perror(path);
+    } else {
+        for (size_t i = 0; i < n;) {
+            unsigned long count = stacks[i].count;
+            size_t j = i + 1;
+            while (j < n && strcmp(stacks[i].text, stacks[j].text) == 0) {
+                count += stacks[j++].count;
+            }
+            fprintf(out, "%s %lu\n", stacks[i].text, count);
+            i = j;
+        }
+        if (out != stdout) {
+            fclose(out);
+        }
+        fprintf(stderr, "profiler: %lu samples from %d threads (%lu dropped) written to %s\n",
+                total, num_rings, dropped, path);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        free(stacks[i].text);
+    }
+    free(stacks);
+    free(stack_counts);
+    stack_counts = NULL;
+    stack_counts_size = stack_counts_used = 0;
+    samples_total = samples_lost = 0;
+    for (size_t i = 0; i < symbols_size; i++) {
+        free(symbols[i].name);
+    }
+    free(symbols);
+    munmap(rings, PROFILER_MAX_THREADS * sizeof(SampleRing));
+    rings = NULL;
+}
+
+static void profiler_stop_at_exit()
+{
+    profiler_stop(exit_path);
+}
+
+// SIGINT and SIGTERM are blocked in every thread and taken here instead, so
+// an interactive run stopped with Ctrl-C still leaves through exit() and its
+// atexit handlers (this profile, the log flush) get to run.
+static void *stop_signal_thread(void *arg)
+{
+    sigset_t *stop_signals = arg;
+    int sig;
+    if (sigwait(stop_signals, &sig) == 0) {
+        exit(128 + sig);
+    }
+    return NULL;
+}
+
+void profiler_start_from_env()
+{
+    static sigset_t stop_signals;
+    const char *path = getenv("LAB_PROFILE");
+    const char *hz = getenv("LAB_PROFILE_HZ");
+    if (path == NULL || path[0] == '\0') {
+        return;
+    }
+    if (profiler_start(hz != NULL ? atoi(hz) : 997) == 0) {
+        exit_path = path;
+        atexit(profiler_stop_at_exit);
+
+        pthread_t thread;
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+        if (pthread_create(&thread, NULL, stop_signal_thread, &stop_signals) == 0) {
+            pthread_detach(thread);
+        } else {
+            pthread_sigmask(SIG_UNBLOCK, &stop_signals, NULL);
+        }
+    }
+}
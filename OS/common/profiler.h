@@ -0,0 +1,30 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/*
+ * SIGPROF sampling profiler shared by the lab programs.
+ *
+ * Every 1/hz seconds of CPU time the SIGPROF handler captures a raw
+ * backtrace into a ring owned by the interrupted thread. A drain thread
+ * empties the rings every 50 ms and counts identical stacks, so a run of
+ * any length is profiled in full. Nothing is symbolized until
+ * profiler_stop(), which writes collapsed stacks ("main;worker;append 42"
+ * per line) ready for flamegraph.pl.
+ *
+ * Link with -rdynamic so dladdr can name functions in the executable
+ * itself; other frames are named module+offset.
+ */
+
+// Start sampling at hz samples per CPU second. Returns 0 on success.
+int profiler_start(int hz);
+
+// Stop sampling and write collapsed stacks to path ("-" for stdout).
+void profiler_stop(const char *path);
+
+// Start if LAB_PROFILE names an output file (LAB_PROFILE_HZ sets the rate,
+// default 997); the profile is then written at exit. SIGINT and SIGTERM are
+// turned into exit(128 + signal) so interrupted runs are written too; call
+// this before creating any threads so they inherit the blocked signals.
+void profiler_start_from_env();
+
+#endif